@@ -14,10 +14,18 @@
 
 #include <QGraphicsScene>
 
+#include "layerstack.h"
 #include "todraw.h"
 
-ActionAdd::ActionAdd(ToDraw *item, QGraphicsScene *scene)
- : m_item(item), m_scene(scene), m_done(false), m_shouldAdd(false)
+bool Action::s_restoring = false;
+
+void Action::setRestoring(bool restoring)
+{
+	s_restoring = restoring;
+}
+
+ActionAdd::ActionAdd(ToDraw *item, QGraphicsScene *scene, LayerStack *layers)
+ : m_item(item), m_scene(scene), m_layers(layers), m_done(false), m_shouldAdd(false)
 {
 	// First m_shouldAdd is false since it was already added
 	// in the playground code
@@ -28,10 +36,17 @@ ActionAdd::~ActionAdd()
 	if (!m_done) delete m_item;
 }
 
+// Whether the item is off the board and only kept for redo
+bool ActionAdd::ownsItem() const
+{
+	return !m_done;
+}
+
 void ActionAdd::redo()
 {
-	if (m_shouldAdd) {
+	if (m_shouldAdd && !isRestoring()) {
 		m_scene->addItem(m_item);
+		m_layers->bringToFront(m_item);
 	}
 	m_done = true;
 	m_shouldAdd = true;
@@ -39,57 +54,134 @@ void ActionAdd::redo()
 
 void ActionAdd::undo()
 {
-	m_scene->removeItem(m_item);
+	if (!isRestoring()) {
+		m_layers->remove(m_item);
+		m_scene->removeItem(m_item);
+	}
 	m_done = false;
 }
 
 
 
-ActionRemove::ActionRemove(ToDraw *item, const QPointF &oldPos, QGraphicsScene *scene)
- : m_item(item), m_scene(scene), m_done(true)
+ActionRemove::ActionRemove(ToDraw *item, const QPointF &oldPos, QGraphicsScene *scene, LayerStack *layers)
+ : m_item(item), m_scene(scene), m_layers(layers), m_done(true)
 {
+	m_below = layers->itemBelow(item);
 	m_oldPos = QPointF(oldPos.x() / scene->width(), oldPos.y() / scene->height());
 }
 
+// Filled in by SavedHistory
+ActionRemove::ActionRemove(QGraphicsScene *scene, LayerStack *layers)
+ : m_item(0), m_below(0), m_scene(scene), m_layers(layers), m_done(true)
+{
+}
+
 ActionRemove::~ActionRemove()
 {
 	if (m_done) delete m_item;
 }
 
+// Whether the item is off the board and only kept for undo
+bool ActionRemove::ownsItem() const
+{
+	return m_done;
+}
+
 void ActionRemove::redo()
 {
-	m_scene->removeItem(m_item);
+	if (!isRestoring()) {
+		m_layers->remove(m_item);
+		m_scene->removeItem(m_item);
+	}
 	m_done = true;
 }
 
 void ActionRemove::undo()
 {
-	m_item->setPos(m_oldPos.x() * m_scene->width(), m_oldPos.y() * m_scene->height());
-	m_scene->addItem(m_item);
+	if (!isRestoring()) {
+		m_item->setPos(m_oldPos.x() * m_scene->width(), m_oldPos.y() * m_scene->height());
+		m_scene->addItem(m_item);
+		m_layers->insertAbove(m_item, m_below);
+	}
 	m_done = false;
 }
 
 
 
-ActionMove::ActionMove(ToDraw *item, const QPointF &oldPos, int zValue, QGraphicsScene *scene)
- : m_item(item), m_zValue(zValue), m_scene(scene)
+// The stacking order is restored relative to the object that was below
+// ours, z values are renumbered from time to time
+ActionMove::ActionMove(ToDraw *item, const QPointF &oldPos, QGraphicsScene *scene, LayerStack *layers)
+ : m_item(item), m_scene(scene), m_layers(layers)
 {
+	m_below = layers->itemBelow(item);
 	m_oldPos = QPointF(oldPos.x() / scene->width(), oldPos.y() / scene->height());
 	m_newPos = QPointF(m_item->pos().x() / scene->width(), m_item->pos().y() / scene->height());
 }
 
+// Filled in by SavedHistory
+ActionMove::ActionMove(QGraphicsScene *scene, LayerStack *layers)
+ : m_item(0), m_below(0), m_scene(scene), m_layers(layers)
+{
+}
+
 void ActionMove::redo()
 {
-	qreal zValue = m_item->zValue();
+	if (isRestoring()) return;
 	m_item->setPos(m_newPos.x() * m_scene->width(), m_newPos.y() * m_scene->height());
-	m_item->setZValue(m_zValue);
-	m_zValue = zValue;
+	m_layers->bringToFront(m_item);
 }
 
 void ActionMove::undo()
 {
-	qreal zValue = m_item->zValue();
+	if (isRestoring()) return;
 	m_item->setPos(m_oldPos.x() * m_scene->width(), m_oldPos.y() * m_scene->height());
-	m_item->setZValue(m_zValue);
-	m_zValue = zValue;
+	m_layers->insertAbove(m_item, m_below);
+}
+
+
+
+// Moving many objects at once is one step to undo. The objects keep their
+// relative stacking order, undo restores each one above the object that
+// was below it, from the bottom up.
+ActionMoveGroup::ActionMoveGroup(const QList<ToDraw *> &items, const QList<QPointF> &oldPos, QGraphicsScene *scene, LayerStack *layers)
+ : m_items(items), m_scene(scene), m_layers(layers)
+{
+	for (int i = 0; i < items.count(); i++)
+	{
+		m_below << layers->itemBelow(items.at(i));
+		m_oldPos << QPointF(oldPos.at(i).x() / scene->width(), oldPos.at(i).y() / scene->height());
+		m_newPos << QPointF(items.at(i)->pos().x() / scene->width(), items.at(i)->pos().y() / scene->height());
+	}
+}
+
+// Filled in by SavedHistory
+ActionMoveGroup::ActionMoveGroup(QGraphicsScene *scene, LayerStack *layers)
+ : m_scene(scene), m_layers(layers)
+{
+}
+
+void ActionMoveGroup::redo()
+{
+	if (isRestoring()) return;
+	setPositions(m_newPos);
+	foreach(ToDraw *item, m_items)
+		m_layers->bringToFront(item);
+}
+
+void ActionMoveGroup::undo()
+{
+	if (isRestoring()) return;
+	setPositions(m_oldPos);
+	for (int i = 0; i < m_items.count(); i++)
+		m_layers->insertAbove(m_items.at(i), m_below.at(i));
+}
+
+// One index update for the whole group instead of one per object
+void ActionMoveGroup::setPositions(const QList<QPointF> &positions)
+{
+	const QGraphicsScene::ItemIndexMethod indexMethod = m_scene->itemIndexMethod();
+	m_scene->setItemIndexMethod(QGraphicsScene::NoIndex);
+	for (int i = 0; i < m_items.count(); i++)
+		m_items.at(i)->setPos(positions.at(i).x() * m_scene->width(), positions.at(i).y() * m_scene->height());
+	m_scene->setItemIndexMethod(indexMethod);
 }
@@ -14,59 +14,117 @@
 #define _ACTION_H_
 
 #include <QUndoCommand>
+#include <QList>
 #include <QPointF>
 
+class LayerStack;
 class ToDraw;
 
 class QGraphicsScene;
 
-class ActionAdd : public QUndoCommand
+// While a history read from a file is put back in the undo stack the
+// commands only take on their done or undone state, the board already
+// shows where the history ended.
+class Action : public QUndoCommand
 {
 	public:
-		ActionAdd(ToDraw *item, QGraphicsScene *scene);
+		static void setRestoring(bool restoring);
+
+	protected:
+		static inline bool isRestoring() { return s_restoring; }
+
+	private:
+		static bool s_restoring;
+};
+
+class ActionAdd : public Action
+{
+	friend class SavedHistory;
+
+	public:
+		ActionAdd(ToDraw *item, QGraphicsScene *scene, LayerStack *layers);
 		~ActionAdd();
 		
 		void redo();
 		void undo();
+
+		bool ownsItem() const;
 	
 	private:
 		ToDraw *m_item;
 		QGraphicsScene *m_scene;
+		LayerStack *m_layers;
 		bool m_done;
 		bool m_shouldAdd;
 };
 
 
-class ActionRemove : public QUndoCommand
+class ActionRemove : public Action
 {
+	friend class SavedHistory;
+
 	public:
-		ActionRemove(ToDraw *item, const QPointF &oldPos, QGraphicsScene *scene);
+		ActionRemove(ToDraw *item, const QPointF &oldPos, QGraphicsScene *scene, LayerStack *layers);
 		~ActionRemove();
 		
 		void redo();
 		void undo();
+
+		bool ownsItem() const;
 	
 	private:
+		ActionRemove(QGraphicsScene *scene, LayerStack *layers);
+
 		ToDraw *m_item;
+		ToDraw *m_below;
 		QPointF m_oldPos;
 		QGraphicsScene *m_scene;
+		LayerStack *m_layers;
 		bool m_done;
 };
 
-class ActionMove : public QUndoCommand
+class ActionMove : public Action
 {
+	friend class SavedHistory;
+
 	public:
-		ActionMove(ToDraw *item, const QPointF &oldPos, int zValue, QGraphicsScene *scene);
+		ActionMove(ToDraw *item, const QPointF &oldPos, QGraphicsScene *scene, LayerStack *layers);
 		
 		void redo();
 		void undo();
 	
 	private:
+		ActionMove(QGraphicsScene *scene, LayerStack *layers);
+
 		ToDraw *m_item;
+		ToDraw *m_below;
 		QPointF m_oldPos;
 		QPointF m_newPos;
-		qreal m_zValue;
 		QGraphicsScene *m_scene;
+		LayerStack *m_layers;
+};
+
+class ActionMoveGroup : public Action
+{
+	friend class SavedHistory;
+
+	public:
+		ActionMoveGroup(const QList<ToDraw *> &items, const QList<QPointF> &oldPos, QGraphicsScene *scene, LayerStack *layers);
+		
+		void redo();
+		void undo();
+	
+	private:
+		ActionMoveGroup(QGraphicsScene *scene, LayerStack *layers);
+
+		void setPositions(const QList<QPointF> &positions);
+		
+		QList<ToDraw *> m_items;		// bottom to top
+		QList<ToDraw *> m_below;
+		QList<QPointF> m_oldPos;
+		QList<QPointF> m_newPos;
+		QGraphicsScene *m_scene;
+		LayerStack *m_layers;
 };
 
 #endif
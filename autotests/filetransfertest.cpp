@@ -0,0 +1,160 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Files read and written through KIO, locally and over HTTP */
+
+#include <KJob>
+
+#include <QDataStream>
+#include <QFile>
+#include <QPointF>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "filetransfer.h"
+
+static const int JOB_TIMEOUT = 10000;	// ms
+
+namespace
+{
+  // Stands in for a web server: answers every request with the payload
+  class HttpServer : public QTcpServer
+  {
+    public:
+      explicit HttpServer(const QByteArray &payload) : m_payload(payload) {}
+
+    protected:
+      void incomingConnection(qintptr descriptor) Q_DECL_OVERRIDE
+      {
+        QTcpSocket *socket = new QTcpSocket(this);
+        socket->setSocketDescriptor(descriptor);
+        connect(socket, &QTcpSocket::readyRead, socket, [this, socket]()
+        {
+          m_request += socket->readAll();
+          if (!m_request.contains("\r\n\r\n")) return;
+
+          socket->write("HTTP/1.1 200 OK\r\n"
+                        "Content-Type: application/octet-stream\r\n"
+                        "Connection: close\r\n"
+                        "Content-Length: " + QByteArray::number(m_payload.size()) + "\r\n\r\n");
+          socket->write(m_payload);
+          socket->disconnectFromHost();
+          m_request.clear();
+        });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+      }
+
+    private:
+      QByteArray m_payload;
+      QByteArray m_request;
+  };
+}
+
+class FileTransferTest : public QObject
+{
+  Q_OBJECT
+
+  private Q_SLOTS:
+    void initTestCase();
+    void getLocalFile();
+    void putLocalFile();
+    void getMissingFile();
+    void getHttp();
+
+  private:
+    bool finish(KJob *job);
+
+    QTemporaryDir m_dir;
+    QByteArray m_payload;
+};
+
+void FileTransferTest::initTestCase()
+{
+  QStandardPaths::setTestModeEnabled(true);
+  qputenv("no_proxy", "127.0.0.1");
+  QVERIFY(m_dir.isValid());
+
+  // what a saved board looks like
+  QDataStream out(&m_payload, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_4_5);
+  out << QStringLiteral("KTuberlingSaveGameV4") << QStringLiteral("default_theme.theme");
+  for (int i = 0; i < 1000; i++)
+    out << QPointF(i, i) << QStringLiteral("eye") << qreal(i);
+}
+
+// Whether the job succeeded, the event loop runs meanwhile
+bool FileTransferTest::finish(KJob *job)
+{
+  job->setAutoDelete(false);
+  QSignalSpy result(job, SIGNAL(result(KJob*)));
+  const bool done = result.wait(JOB_TIMEOUT);
+  return done && job->error() == 0;
+}
+
+void FileTransferTest::getLocalFile()
+{
+  const QString fileName = m_dir.path() + QLatin1String("/board.tuberling");
+  QFile file(fileName);
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  file.write(m_payload);
+  file.close();
+
+  KJob *job = FileTransfer::get(QUrl::fromLocalFile(fileName));
+  QVERIFY(finish(job));
+  QCOMPARE(FileTransfer::data(job), m_payload);
+  delete job;
+}
+
+void FileTransferTest::putLocalFile()
+{
+  const QString fileName = m_dir.path() + QLatin1String("/saved.tuberling");
+  KJob *job = FileTransfer::put(m_payload, QUrl::fromLocalFile(fileName));
+  QVERIFY(finish(job));
+  delete job;
+
+  QFile file(fileName);
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  QCOMPARE(file.readAll(), m_payload);
+
+  // saving again replaces the file
+  job = FileTransfer::put(m_payload.left(100), QUrl::fromLocalFile(fileName));
+  QVERIFY(finish(job));
+  delete job;
+  file.close();
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  QCOMPARE(file.readAll(), m_payload.left(100));
+}
+
+void FileTransferTest::getMissingFile()
+{
+  KJob *job = FileTransfer::get(QUrl::fromLocalFile(m_dir.path() + QLatin1String("/missing.tuberling")));
+  QVERIFY(!finish(job));
+  QVERIFY(job->error() != 0);
+  delete job;
+}
+
+void FileTransferTest::getHttp()
+{
+  HttpServer server(m_payload);
+  QVERIFY(server.listen(QHostAddress::LocalHost));
+
+  const QUrl url(QStringLiteral("http://127.0.0.1:%1/board.tuberling").arg(server.serverPort()));
+  KJob *job = FileTransfer::get(url);
+  QVERIFY(finish(job));
+  QCOMPARE(FileTransfer::data(job), m_payload);
+  delete job;
+}
+
+QTEST_MAIN(FileTransferTest)
+
+#include "filetransfertest.moc"
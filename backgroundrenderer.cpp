@@ -0,0 +1,220 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Renders the playgrounds outside of the GUI thread */
+
+#include "backgroundrenderer.h"
+
+#include <QCoreApplication>
+#include <QPainter>
+#include <QSvgRenderer>
+
+#include "spritecache.h"
+#include "themebundle.h"
+#include "tracer.h"
+
+// Largest side of the hit test masks, in pixels
+static const int MASK_SIZE = 256;
+
+RenderWorker::~RenderWorker()
+{
+  qDeleteAll(m_renderers);
+}
+
+void RenderWorker::render(quint32 target, quint32 document, const QByteArray &data, const QString &element, const QSize &size, const QString &cacheKey)
+{
+  QImage image;
+  if (SpriteCache::find(cacheKey, &image) && image.size() == size)
+  {
+    emit rendered(target, image, element.isEmpty() ? QImage() : BackgroundRenderer::hitMask(image), true);
+    return;
+  }
+
+  QSvgRenderer *renderer = m_renderers.value(document);
+  if (!renderer)
+  {
+    TraceScope trace("backgroundParse");
+    renderer = new QSvgRenderer(data);
+    m_renderers.insert(document, renderer);
+  }
+
+  TraceScope trace("backgroundRender");
+  image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+  image.fill(Qt::transparent);
+  QPainter painter(&image);
+  if (element.isEmpty())
+    renderer->render(&painter);
+  else
+    renderer->render(&painter, element);
+  painter.end();
+
+  // the view does not wait for the other sessions
+  emit rendered(target, image, element.isEmpty() ? QImage() : BackgroundRenderer::hitMask(image), false);
+  SpriteCache::insert(cacheKey, image);
+}
+
+// Drop the documents of a catalog, the index of the catalog is the
+// upper half of their key
+void RenderWorker::forget(quint32 catalog, quint32 serial)
+{
+  QHash<quint32, QSvgRenderer *>::iterator it = m_renderers.begin();
+  while (it != m_renderers.end())
+  {
+    if (it.key() >> 16 == catalog)
+    {
+      delete it.value();
+      it = m_renderers.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  emit forgotten(serial);
+}
+
+BackgroundRenderer::BackgroundRenderer()
+ : QObject(qApp), m_forgetSerial(0)
+{
+  m_worker = new RenderWorker();
+  m_worker->moveToThread(&m_thread);
+  connect(this, &BackgroundRenderer::renderRequested, m_worker, &RenderWorker::render);
+  connect(this, &BackgroundRenderer::forgetRequested, m_worker, &RenderWorker::forget);
+  connect(m_worker, &RenderWorker::rendered, this, &BackgroundRenderer::workerRendered);
+  connect(m_worker, &RenderWorker::forgotten, this, &BackgroundRenderer::workerForgot);
+  m_thread.start(QThread::LowPriority);
+
+  m_idleWorker = new RenderWorker();
+  m_idleWorker->moveToThread(&m_idleThread);
+  connect(this, &BackgroundRenderer::idleRenderRequested, m_idleWorker, &RenderWorker::render);
+  connect(this, &BackgroundRenderer::forgetRequested, m_idleWorker, &RenderWorker::forget);
+  connect(m_idleWorker, &RenderWorker::rendered, this, &BackgroundRenderer::workerRendered);
+  connect(m_idleWorker, &RenderWorker::forgotten, this, &BackgroundRenderer::workerForgot);
+  m_idleThread.start(QThread::IdlePriority);
+}
+
+BackgroundRenderer::~BackgroundRenderer()
+{
+  m_thread.quit();
+  m_idleThread.quit();
+  m_thread.wait();
+  m_idleThread.wait();
+  delete m_worker;
+  delete m_idleWorker;
+  foreach(const Forget &forget, m_forgets)
+    delete forget.bundle;
+}
+
+BackgroundRenderer *BackgroundRenderer::instance()
+{
+  static BackgroundRenderer *renderer = new BackgroundRenderer();
+  return renderer;
+}
+
+// Queue a rendering, unless the same one is already queued. One queued at
+// idle priority is queued again in the other thread once a view waits for
+// it, whichever is done first is used.
+void BackgroundRenderer::render(quint32 target, quint32 document, const QByteArray &data, const QString &element, const QSize &size, const QString &cacheKey, Priority priority)
+{
+  QHash<quint32, QSize>::iterator it = m_pending.find(target);
+  if (it != m_pending.end() && it.value() == size && (priority == Idle || !m_pendingIdle.contains(target))) return;
+
+  m_pending.insert(target, size);
+  if (priority == Idle)
+  {
+    m_pendingIdle.insert(target);
+    emit idleRenderRequested(target, document, data, element, size, cacheKey);
+  }
+  else
+  {
+    m_pendingIdle.remove(target);
+    emit renderRequested(target, document, data, element, size, cacheKey);
+  }
+}
+
+// Queued after the renderings already requested. The bundle, if any, is
+// taken over: those renderings may still read from it. Nothing is pending
+// for the catalog any more, the same renderings can be asked for again.
+void BackgroundRenderer::forget(quint32 catalog, ThemeBundle *bundle)
+{
+  const quint32 serial = ++m_forgetSerial;
+  Forget forget;
+  forget.catalog = catalog;
+  forget.bundle = bundle;
+  forget.workers = 2;
+  m_forgets.insert(serial, forget);
+  m_forgetting[m_worker] << catalog;
+  m_forgetting[m_idleWorker] << catalog;
+
+  QHash<quint32, QSize>::iterator it = m_pending.begin();
+  while (it != m_pending.end())
+  {
+    if (it.key() >> 16 == catalog)
+    {
+      m_pendingIdle.remove(it.key());
+      it = m_pending.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  emit forgetRequested(catalog, serial);
+}
+
+void BackgroundRenderer::workerForgot(quint32 serial)
+{
+  QHash<quint32, Forget>::iterator it = m_forgets.find(serial);
+  if (it == m_forgets.end()) return;
+
+  m_forgetting[sender()].removeOne(it->catalog);
+  if (--it->workers > 0) return;
+
+  delete it->bundle;
+  m_forgets.erase(it);
+}
+
+void BackgroundRenderer::workerRendered(quint32 target, const QImage &image, const QImage &mask, bool shared)
+{
+  // requested before the catalog was forgotten
+  if (m_forgetting.value(sender()).contains(target >> 16)) return;
+
+  if (m_pending.value(target) == image.size())
+  {
+    m_pending.remove(target);
+    m_pendingIdle.remove(target);
+  }
+  emit rendered(target, image, mask, shared);
+}
+
+// One bit per pixel of the rendering, whether it is drawn there, sampled
+// down for the biggest renderings. Color 1 of the mask is opaque.
+QImage BackgroundRenderer::hitMask(const QImage &rendering)
+{
+  QSize size = rendering.size();
+  if (size.width() > MASK_SIZE || size.height() > MASK_SIZE)
+    size.scale(MASK_SIZE, MASK_SIZE, Qt::KeepAspectRatio);
+  size = size.expandedTo(QSize(1, 1));
+
+  QImage mask(size, QImage::Format_MonoLSB);
+  mask.setColorTable(QVector<QRgb>() << qRgba(0, 0, 0, 0) << qRgba(0, 0, 0, 255));
+  mask.fill(0);
+  for (int y = 0; y < size.height(); y++)
+  {
+    const QRgb *line = reinterpret_cast<const QRgb *>(rendering.constScanLine(y * rendering.height() / size.height()));
+    uchar *bits = mask.scanLine(y);
+    for (int x = 0; x < size.width(); x++)
+    {
+      if (qAlpha(line[x * rendering.width() / size.width()]))
+        bits[x >> 3] |= 1 << (x & 7);
+    }
+  }
+  return mask;
+}
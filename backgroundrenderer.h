@@ -0,0 +1,112 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Renders the playgrounds outside of the GUI thread */
+
+#ifndef _BACKGROUNDRENDERER_H_
+#define _BACKGROUNDRENDERER_H_
+
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QSet>
+#include <QSize>
+#include <QThread>
+
+class QSvgRenderer;
+class ThemeBundle;
+
+// Lives in the render thread, keeps every document it parsed
+class RenderWorker : public QObject
+{
+  Q_OBJECT
+
+  public:
+    ~RenderWorker();
+
+  public Q_SLOTS:
+    void render(quint32 target, quint32 document, const QByteArray &data, const QString &element, const QSize &size, const QString &cacheKey);
+    void forget(quint32 catalog, quint32 serial);
+
+  Q_SIGNALS:
+    void rendered(quint32 target, const QImage &image, const QImage &mask, bool shared);
+    void forgotten(quint32 serial);
+
+  private:
+    QHash<quint32, QSvgRenderer *> m_renderers;
+};
+
+// Parsing a board and rendering it at full resolution is done in a thread
+// of its own, the playground shows what it has meanwhile.
+//
+// A target is the element handle the image is for, a document identifies
+// the SVG data it is rendered from; the data is only parsed the first time.
+// The documents of a catalog are kept until the catalog is released.
+// Bundle data is passed without a copy, so a bundle the catalog is done
+// with is only deleted once both threads went past the requests made
+// before. Renderings for the catalog they finish meanwhile are outdated
+// and dropped.
+//
+// Renderings done ahead of need go to a second thread running at idle
+// priority, they never hold up those a view waits for.
+//
+// The threads look the renderings up in the sprite cache before
+// rendering them, and add those they render to it once they handed them
+// over. Shared renderings are those mapped from the cache.
+//
+// The hit test mask of an element comes with each of its renderings, so
+// the GUI thread never renders anything to test a click.
+class BackgroundRenderer : public QObject
+{
+  Q_OBJECT
+
+  public:
+    enum Priority { Interactive, Idle };
+
+    static BackgroundRenderer *instance();
+    ~BackgroundRenderer();
+
+    void render(quint32 target, quint32 document, const QByteArray &data, const QString &element, const QSize &size, const QString &cacheKey, Priority priority = Interactive);
+    void forget(quint32 catalog, ThemeBundle *bundle = 0);
+
+    static QImage hitMask(const QImage &rendering);
+
+  Q_SIGNALS:
+    void rendered(quint32 target, const QImage &image, const QImage &mask, bool shared);
+    void renderRequested(quint32 target, quint32 document, const QByteArray &data, const QString &element, const QSize &size, const QString &cacheKey);
+    void idleRenderRequested(quint32 target, quint32 document, const QByteArray &data, const QString &element, const QSize &size, const QString &cacheKey);
+    void forgetRequested(quint32 catalog, quint32 serial);
+
+  private Q_SLOTS:
+    void workerRendered(quint32 target, const QImage &image, const QImage &mask, bool shared);
+    void workerForgot(quint32 serial);
+
+  private:
+    BackgroundRenderer();
+
+    QThread m_thread;
+    RenderWorker *m_worker;
+    QThread m_idleThread;
+    RenderWorker *m_idleWorker;
+    QHash<quint32, QSize> m_pending;		// what is being rendered for each target
+    QSet<quint32> m_pendingIdle;		// targets only the idle thread renders
+    class Forget
+    {
+      public:
+        quint32 catalog;
+        ThemeBundle *bundle;			// to delete once both workers are done
+        int workers;				// that did not go past it yet
+    };
+
+    QHash<quint32, Forget> m_forgets;		// by serial
+    QHash<const QObject *, QList<quint32> > m_forgetting;	// catalogs, by worker
+    quint32 m_forgetSerial;
+};
+
+#endif
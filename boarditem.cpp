@@ -0,0 +1,58 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* The board behind the objects */
+
+#include "boarditem.h"
+
+#include <QPainter>
+#include <QSvgRenderer>
+
+#include "elementcatalog.h"
+
+BoardItem::BoardItem(ElementCatalog *catalog)
+ : m_catalog(catalog)
+{
+}
+
+// The catalog read the board again, its size may be another one
+void BoardItem::boardChanged()
+{
+  prepareGeometryChange();
+}
+
+QRectF BoardItem::boundingRect() const
+{
+  return QRectF(QPointF(0, 0), m_catalog->defaultSize());
+}
+
+void BoardItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *widget)
+{
+  const QRectF rect = boundingRect();
+
+  // not drawing on the view, so no rendering can be reused
+  if (!widget)
+  {
+    m_catalog->renderer()->render(painter, rect);
+    return;
+  }
+
+  const QSize deviceSize = painter->worldTransform().mapRect(rect).size().toSize();
+  if (deviceSize.isEmpty()) return;
+
+  // nothing rendered yet, the view shows the background color of the
+  // playground until the background renderer is done
+  const QImage image = m_catalog->boardImage(deviceSize);
+  if (image.isNull()) return;
+
+  painter->save();
+  painter->setRenderHint(QPainter::SmoothPixmapTransform);
+  painter->drawImage(rect, image, image.rect());
+  painter->restore();
+}
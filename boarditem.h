@@ -0,0 +1,37 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* The board behind the objects */
+
+#ifndef _BOARDITEM_H_
+#define _BOARDITEM_H_
+
+#include <QGraphicsItem>
+
+class ElementCatalog;
+
+// Draws the whole SVG document of the playground. On screen it shows the
+// rendering the background renderer made for the current size, or the
+// best one available until then, never rendering the board itself.
+// Printing and exporting get the vectors.
+class BoardItem : public QGraphicsItem
+{
+  public:
+    explicit BoardItem(ElementCatalog *catalog);
+
+    void boardChanged();
+
+    QRectF boundingRect() const;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0);
+
+  private:
+    ElementCatalog *m_catalog;
+};
+
+#endif
@@ -0,0 +1,208 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Gets the playgrounds likely to be shown next ready ahead of time */
+
+#include "boardprefetcher.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QCoreApplication>
+#include <QEvent>
+#include <QFileInfo>
+#include <QMap>
+
+#include "elementcatalog.h"
+#include "playground.h"
+#include "toplevel.h"
+
+// How long the input has to be quiet before the next step, in ms
+static const int IDLE_DELAY = 1500;
+
+// How many playgrounds are got ready
+static const int PREFETCHED_BOARDS = 2;
+
+// Counts are halved past this, so recent habits win over old ones
+static const int MAX_SWITCH_COUNT = 64;
+
+static const char *SWITCHES_GROUP = "Gameboard Switches";
+
+static KConfigGroup switchesFrom(const QString &gameboard)
+{
+  return KConfigGroup(KSharedConfig::openConfig(), SWITCHES_GROUP).group(QFileInfo(gameboard).fileName());
+}
+
+BoardPrefetcher::BoardPrefetcher(TopLevel *topLevel)
+ : QObject(topLevel), m_topLevel(topLevel)
+{
+  m_idleTimer.setSingleShot(true);
+  m_idleTimer.setInterval(IDLE_DELAY);
+  connect(&m_idleTimer, &QTimer::timeout, this, &BoardPrefetcher::prefetchStep);
+  qApp->installEventFilter(this);
+}
+
+// Count a switch, the config is written with the other options
+void BoardPrefetcher::recordSwitch(const QString &from, const QString &to)
+{
+  if (from.isEmpty() || from == to) return;
+
+  KConfigGroup switches = switchesFrom(from);
+  const QString target = QFileInfo(to).fileName();
+  const int count = switches.readEntry(target, 0) + 1;
+  switches.writeEntry(target, count);
+
+  if (count > MAX_SWITCH_COUNT)
+  {
+    foreach(const QString &key, switches.keyList())
+    {
+      const int halved = switches.readEntry(key, 0) / 2;
+      if (halved > 0)
+        switches.writeEntry(key, halved);
+      else
+        switches.deleteEntry(key);
+    }
+  }
+}
+
+// A copy of the counts, to be written by another thread
+BoardPrefetcher::Switches BoardPrefetcher::switches() const
+{
+  Switches result;
+  const KConfigGroup all(KSharedConfig::openConfig(), SWITCHES_GROUP);
+  foreach(const QString &from, all.groupList())
+  {
+    const KConfigGroup switches = all.group(from);
+    foreach(const QString &to, switches.keyList())
+      result[from].insert(to, switches.readEntry(to, 0));
+  }
+  return result;
+}
+
+// Replace the counts in the configuration, counts halved away are gone
+// from the copy as well
+void BoardPrefetcher::writeSwitches(KConfig *config, const Switches &switches)
+{
+  KConfigGroup all(config, SWITCHES_GROUP);
+  all.deleteGroup();
+  Switches::const_iterator it;
+  for (it = switches.constBegin(); it != switches.constEnd(); ++it)
+  {
+    KConfigGroup group = all.group(it.key());
+    QMap<QString, int>::const_iterator count;
+    for (count = it.value().constBegin(); count != it.value().constEnd(); ++count)
+      group.writeEntry(count.key(), count.value());
+  }
+}
+
+// Start over with the playgrounds likely to follow this one, let go of
+// those got ready that are not any more
+void BoardPrefetcher::setCurrentGameboard(const QString &gameboard)
+{
+  m_candidates = likelyNext(gameboard);
+  foreach(const QString &held, m_held)
+  {
+    if (m_candidates.contains(held)) continue;
+    m_held.remove(held);
+    ElementCatalog::forGameboard(held)->deref();
+  }
+
+  if (m_candidates.isEmpty())
+    m_idleTimer.stop();
+  else
+    m_idleTimer.start();
+}
+
+// Any input puts the work off until it stops
+bool BoardPrefetcher::eventFilter(QObject *, QEvent *event)
+{
+  switch (event->type())
+  {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::MouseMove:
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+    case QEvent::Wheel:
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::Resize:
+      if (!m_candidates.isEmpty())
+        m_idleTimer.start();
+      break;
+
+    default:
+      break;
+  }
+  return false;
+}
+
+// Load the next playground, or have its board rendered; playgrounds are
+// dropped once ready. While a rendering is under way this only checks
+// whether it is done. Playgrounds without a bundle are only prerendered
+// once loaded: parsing their SVG here would stall the GUI.
+void BoardPrefetcher::prefetchStep()
+{
+  PlayGround *playGround = m_topLevel->currentPlayGround();
+  while (!m_candidates.isEmpty())
+  {
+    const QString gameboard = m_candidates.first();
+    const bool loaded = ElementCatalog::forGameboard(gameboard)->isLoaded();
+    ElementCatalog *catalog = PlayGround::loadCatalog(gameboard, true);
+    if (!catalog)
+    {
+      m_candidates.removeFirst();
+      continue;
+    }
+    if (!m_held.contains(gameboard))
+    {
+      catalog->ref();
+      m_held.insert(gameboard);
+    }
+    if (!loaded) break;
+
+    const QSize size = playGround->boardSize(catalog);
+    if (size.isEmpty() || !catalog->prerender(size)) break;
+    m_candidates.removeFirst();
+  }
+
+  if (!m_candidates.isEmpty())
+    m_idleTimer.start();
+}
+
+// The playgrounds switched to most often from this one, then its
+// neighbours in the list
+QStringList BoardPrefetcher::likelyNext(const QString &gameboard) const
+{
+  const QStringList boards = m_topLevel->gameboards();
+  QMap<QString, QString> byName;
+  foreach(const QString &board, boards)
+    byName.insert(QFileInfo(board).fileName(), board);
+
+  const KConfigGroup switches = switchesFrom(gameboard);
+  QMultiMap<int, QString> byCount;
+  foreach(const QString &key, switches.keyList())
+  {
+    if (byName.contains(key))
+      byCount.insert(-switches.readEntry(key, 0), byName.value(key));
+  }
+
+  QStringList result = byCount.values();
+  const int index = boards.indexOf(gameboard);
+  if (index >= 0 && boards.count() > 1)
+  {
+    result << boards.at((index + 1) % boards.count());
+    result << boards.at((index + boards.count() - 1) % boards.count());
+  }
+
+  result.removeDuplicates();
+  result.removeAll(gameboard);
+  return result.mid(0, PREFETCHED_BOARDS);
+}
@@ -0,0 +1,63 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Gets the playgrounds likely to be shown next ready ahead of time */
+
+#ifndef _BOARDPREFETCHER_H_
+#define _BOARDPREFETCHER_H_
+
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+class KConfig;
+class TopLevel;
+
+// Remembers which playground people switch to from each playground, and
+// while the game sits idle loads the most likely next ones and renders
+// their board at the size of the current view. Boards never switched
+// from yet are followed by their neighbours in the playground list.
+//
+// One step is done at a time, only once no input arrived for a while;
+// the rendering itself runs at idle priority. The catalogs of the
+// playgrounds got ready are held like a view would, and released once
+// they are no longer likely to follow.
+class BoardPrefetcher : public QObject
+{
+  Q_OBJECT
+
+  public:
+    // Switch counts by the playground switched from and to
+    typedef QMap<QString, QMap<QString, int> > Switches;
+
+    explicit BoardPrefetcher(TopLevel *topLevel);
+
+    void recordSwitch(const QString &from, const QString &to);
+    Switches switches() const;
+    static void writeSwitches(KConfig *config, const Switches &switches);
+    void setCurrentGameboard(const QString &gameboard);
+
+  protected:
+    bool eventFilter(QObject *watched, QEvent *event) Q_DECL_OVERRIDE;
+
+  private Q_SLOTS:
+    void prefetchStep();
+
+  private:
+    QStringList likelyNext(const QString &gameboard) const;
+
+    TopLevel *m_topLevel;
+    QStringList m_candidates;		// still to get ready, most likely first
+    QSet<QString> m_held;		// got ready, ref'd until no longer likely
+    QTimer m_idleTimer;			// fires once input stopped for a while
+};
+
+#endif
@@ -0,0 +1,766 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Catalog of the elements of a playground */
+
+#include "elementcatalog.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QPainter>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "backgroundrenderer.h"
+#include "spritecache.h"
+#include "svgcache.h"
+#include "themebundle.h"
+#include "thememanifest.h"
+
+// Width of the low resolution board shown while the real one is rendered
+static const int PREVIEW_WIDTH = 480;
+
+namespace
+{
+  QVector<ElementCatalog *> catalogs;
+  QHash<QString, ElementCatalog *> catalogsByGameboard;
+}
+
+int ElementCatalog::s_renderingHolds = 0;
+
+ElementCatalog::ElementCatalog(quint32 index)
+ : m_index(index), m_refCount(0), m_loaded(false), m_parsed(false), m_bundle(0), m_useCount(0)
+{
+}
+
+ElementCatalog::~ElementCatalog()
+{
+  qDeleteAll(m_fragmentRenderers);
+  delete m_bundle;
+}
+
+// The catalog of a playground, created empty the first time
+ElementCatalog *ElementCatalog::forGameboard(const QString &gameboardFile)
+{
+  ElementCatalog *catalog = catalogsByGameboard.value(gameboardFile);
+  if (!catalog)
+  {
+    catalog = new ElementCatalog(catalogs.count());
+    catalogs << catalog;
+    catalogsByGameboard.insert(gameboardFile, catalog);
+  }
+  return catalog;
+}
+
+// The gameboards a catalog was created for
+QStringList ElementCatalog::gameboards()
+{
+  return catalogsByGameboard.keys();
+}
+
+ElementCatalog *ElementCatalog::fromHandle(quint32 handle)
+{
+  return catalogs.at(handle >> 16);
+}
+
+bool ElementCatalog::isLoaded() const
+{
+  return m_loaded;
+}
+
+bool ElementCatalog::load(const QString &svgFile)
+{
+  setSourceFile(svgFile);
+  m_loaded = m_parsed = m_renderer.load(SvgCache::document(svgFile));
+  if (m_loaded)
+  {
+    m_defaultSize = m_renderer.defaultSize();
+    m_backgroundRect = m_renderer.boundsOnElement(QStringLiteral( "background" ));
+    loadPreview();
+  }
+  return m_loaded;
+}
+
+// Load the objects from a bundle compiled by ktuberling-themec, the board
+// is only parsed when it has to be drawn in this thread
+bool ElementCatalog::loadBundle(const QString &bundleFile)
+{
+  ThemeBundle *bundle = new ThemeBundle();
+  if (!bundle->open(bundleFile))
+  {
+    delete bundle;
+    return false;
+  }
+
+  m_bundle = bundle;
+  setSourceFile(bundleFile);
+  m_defaultSize = bundle->defaultSize;
+  m_backgroundRect = bundle->backgroundRect;
+  foreach(const ThemeBundle::Element &element, bundle->elements)
+    setObject(element.name, element.sound, element.scale, element.bounds, element.blob);
+  m_loaded = true;
+  loadPreview();
+  return true;
+}
+
+// Load the playground described by a .theme file, from its bundle if it
+// was compiled and is up to date
+bool ElementCatalog::loadGameboard(const QString &gameboardFile, const QString &svgFile)
+{
+  const ThemeManifest *manifest = ThemeManifest::get(gameboardFile);
+  if (!manifest) return false;
+
+  const QString bundleFile = ThemeBundle::fileFor(gameboardFile, svgFile);
+  if (!bundleFile.isEmpty() && loadBundle(bundleFile))
+    return true;
+
+  if (!load(svgFile))
+    return false;
+
+  foreach(const ThemeManifest::Object &object, manifest->objects)
+  {
+    if (renderer()->elementExists(object.name))
+    {
+      addObject(object.name, object.sound, object.scale);
+    }
+    else
+    {
+      qWarning() << object.name << "does not exist. Check" << gameboardFile;
+    }
+  }
+  return true;
+}
+
+// Read the playground again after its files changed. Elements keep their
+// ids, so the objects on the boards and in the undo histories stay valid;
+// objects gone from the warehouse stay as elements only used by them.
+// Only the renderings of the changed elements and of the board are
+// dropped, the others are still good.
+bool ElementCatalog::reload(const QString &gameboardFile, const QString &svgFile, const QSet<QString> &changed)
+{
+  const QVector<QRectF> oldBounds = m_bounds;
+  const QVector<qreal> oldScales = m_scales;
+
+  qDeleteAll(m_fragmentRenderers);
+  m_fragmentRenderers.fill(0);
+  if (m_parsed)
+  {
+    m_renderer.load(QByteArray());
+    m_parsed = false;
+  }
+  // queued renderings may still read the old bundle; they are dropped
+  // and asked for again when drawn
+  BackgroundRenderer::instance()->forget(m_index, m_bundle);
+  m_bundle = 0;
+  for (int i = 0; i < m_renderings.count(); i++)
+  {
+    m_renderings[i].pendingSize = QSize();
+    m_renderings[i].pendingIdle = false;
+  }
+  m_loaded = false;
+  m_objects.clear();
+  m_preview = QImage();
+
+  // the fragments of the old bundle are gone even if the files can not
+  // be read; the objects keep their elements until they can
+  const bool loaded = loadGameboard(gameboardFile, svgFile);
+  for (int id = 0; id < count(); id++)
+  {
+    const bool isChanged = changed.contains(m_names.at(id));
+    if (!m_objects.contains(id))
+    {
+      m_blobs[id] = ThemeBundle::BoardBlob;
+      if (loaded && isChanged) m_bounds[id] = renderer()->boundsOnElement(m_names.at(id));
+    }
+
+    if (isChanged)
+    {
+      Rendering *kept = renderings(id);
+      for (int i = 0; i < RenderSlots; i++)
+        kept[i] = Rendering();
+    }
+    if (isChanged || id >= oldBounds.count() || m_bounds.at(id) != oldBounds.at(id) || m_scales.at(id) != oldScales.at(id))
+    {
+      m_masks[id] = QImage();
+    }
+  }
+
+  for (int i = 0; i < RenderSlots; i++)
+    m_boardRenderings[i] = Rendering();
+  return loaded;
+}
+
+QSvgRenderer *ElementCatalog::renderer()
+{
+  if (!m_parsed)
+  {
+    m_renderer.load(document(ThemeBundle::BoardBlob));
+    m_parsed = true;
+  }
+  return &m_renderer;
+}
+
+// The renderer to draw an element with
+QSvgRenderer *ElementCatalog::renderer(int id)
+{
+  const int blob = m_blobs.at(id);
+  if (blob == ThemeBundle::BoardBlob) return renderer();
+
+  QSvgRenderer *&fragmentRenderer = m_fragmentRenderers[id];
+  if (!fragmentRenderer)
+    fragmentRenderer = new QSvgRenderer(m_bundle->blob(blob));
+  return fragmentRenderer;
+}
+
+QSize ElementCatalog::defaultSize() const
+{
+  return m_defaultSize;
+}
+
+QRectF ElementCatalog::backgroundRect() const
+{
+  return m_backgroundRect;
+}
+
+// The low resolution board, null if no session saved one yet
+QImage ElementCatalog::preview() const
+{
+  return m_preview;
+}
+
+// Add an object of the warehouse
+int ElementCatalog::addObject(const QString &name, const QString &sound, qreal scale)
+{
+  return setObject(name, sound, scale, renderer()->boundsOnElement(name), ThemeBundle::BoardBlob);
+}
+
+// Make the element an object of the warehouse, appending it unless an
+// earlier load or a file already interned it. The first of several
+// objects with the same name wins. -1 if the catalog is full.
+int ElementCatalog::setObject(const QString &name, const QString &sound, qreal scale, const QRectF &bounds, int blob)
+{
+  int id = find(name);
+  if (id < 0)
+  {
+    id = append(name, sound, scale, bounds, blob);
+    if (id < 0) return -1;
+  }
+  else if (!m_objects.contains(id))
+  {
+    m_sounds[id] = sound;
+    m_scales[id] = scale;
+    m_bounds[id] = bounds;
+    m_blobs[id] = blob;
+  }
+  else
+  {
+    return id;
+  }
+  m_objects << id;
+  return id;
+}
+
+// Get the id of any element, elements that are not objects of the
+// warehouse are not drawn, as it has always been. -1 once the catalog
+// holds MaxElements elements, only files naming that many can fill it.
+int ElementCatalog::intern(const QString &name)
+{
+  int id = find(name);
+  if (id < 0)
+    id = append(name, QString(), 0, renderer()->boundsOnElement(name), ThemeBundle::BoardBlob);
+  return id;
+}
+
+int ElementCatalog::find(const QString &name) const
+{
+  return m_ids.value(name, -1);
+}
+
+int ElementCatalog::append(const QString &name, const QString &sound, qreal scale, const QRectF &bounds, int blob)
+{
+  const int id = m_names.count();
+  if (id >= MaxElements)
+  {
+    qWarning() << "Too many elements, ignoring" << name;
+    return -1;
+  }
+  m_ids.insert(name, id);
+  m_names << name;
+  m_sounds << sound;
+  m_bounds << bounds;
+  m_scales << scale;
+  m_blobs << blob;
+  m_fragmentRenderers << 0;
+  m_renderings.resize(m_renderings.count() + RenderSlots);
+  m_masks << QImage();
+  return id;
+}
+
+quint32 ElementCatalog::handle(int id) const
+{
+  return (m_index << 16) | quint32(id);
+}
+
+int ElementCatalog::count() const
+{
+  return m_names.count();
+}
+
+int ElementCatalog::objectCount() const
+{
+  return m_objects.count();
+}
+
+// The element id of the index-th object of the warehouse
+int ElementCatalog::objectId(int index) const
+{
+  return m_objects.at(index);
+}
+
+// The object of the warehouse at the given position, -1 if none
+int ElementCatalog::objectAt(const QPointF &scenePos) const
+{
+  const QRectF *bounds = m_bounds.constData();
+  foreach(int id, m_objects)
+  {
+    if (bounds[id].contains(scenePos)) return id;
+  }
+  return -1;
+}
+
+// Whether the element is drawn at that point, given as a fraction of its
+// width and height. Anywhere in its bounds until it was rendered once.
+bool ElementCatalog::opaqueAt(int id, qreal x, qreal y)
+{
+  const QImage image = mask(id);
+  if (image.isNull()) return true;
+
+  const int maskX = int(x * image.width());
+  const int maskY = int(y * image.height());
+  if (x < 0 || y < 0 || maskX >= image.width() || maskY >= image.height()) return false;
+  return image.constScanLine(maskY)[maskX >> 3] & (1 << (maskX & 7));
+}
+
+// The hit test mask of the element, null until it was rendered once.
+// Masks come with the background renderings; released ones are sampled
+// again from a kept rendering.
+QImage ElementCatalog::mask(int id)
+{
+  if (m_masks.at(id).isNull())
+  {
+    const Rendering *latest = latestRendering(id);
+    if (latest) m_masks[id] = BackgroundRenderer::hitMask(latest->image);
+  }
+  return m_masks.at(id);
+}
+
+// The renderings kept for an element, or for the board
+ElementCatalog::Rendering *ElementCatalog::renderings(int id)
+{
+  if (id == BoardId) return m_boardRenderings;
+  return m_renderings.data() + id * RenderSlots;
+}
+
+const ElementCatalog::Rendering *ElementCatalog::renderings(int id) const
+{
+  if (id == BoardId) return m_boardRenderings;
+  return m_renderings.constData() + id * RenderSlots;
+}
+
+// The rendering at the given size, 0 if there is none
+ElementCatalog::Rendering *ElementCatalog::rendering(int id, const QSize &size)
+{
+  Rendering *kept = renderings(id);
+  for (int i = 0; i < RenderSlots; i++)
+  {
+    if (!kept[i].image.isNull() && kept[i].image.size() == size)
+      return &kept[i];
+  }
+  return 0;
+}
+
+// The rendering used last, whatever its size
+ElementCatalog::Rendering *ElementCatalog::latestRendering(int id)
+{
+  Rendering *kept = renderings(id);
+  Rendering *latest = 0;
+  for (int i = 0; i < RenderSlots; i++)
+  {
+    if (!kept[i].image.isNull() && (!latest || kept[i].lastUsed > latest->lastUsed))
+      latest = &kept[i];
+  }
+  return latest;
+}
+
+// Where a new size goes: an unused slot, or else the least recently used one
+ElementCatalog::Rendering *ElementCatalog::freeRendering(int id)
+{
+  Rendering *kept = renderings(id);
+  Rendering *result = &kept[0];
+  for (int i = 1; i < RenderSlots; i++)
+  {
+    if (kept[i].lastUsed < result->lastUsed)
+      result = &kept[i];
+  }
+  return result;
+}
+
+QString ElementCatalog::cacheKey(int id, const QSize &size) const
+{
+  const QString element = id == BoardId ? QStringLiteral( "#board" ) : m_names.at(id);
+  return m_cacheKey + QLatin1Char( '/' ) + element + QStringLiteral( "/%1x%2" ).arg(size.width()).arg(size.height());
+}
+
+// Have the background renderer render at that size, unless it already does.
+// Idle renderings are done when nothing else needs the processor; one
+// a view now waits for is asked for again at the usual priority.
+void ElementCatalog::queueRendering(int id, const QSize &size, bool idle)
+{
+  if (s_renderingHolds) return;
+
+  Rendering *target = 0;
+  Rendering *kept = renderings(id);
+  for (int i = 0; i < RenderSlots && !target; i++)
+  {
+    if (kept[i].pendingSize != size) continue;
+    if (idle || !kept[i].pendingIdle) return;
+    target = &kept[i];
+  }
+
+  if (!target)
+  {
+    target = freeRendering(id);
+    target->pendingSize = size;
+  }
+  target->pendingIdle = idle;
+  target->lastUsed = ++m_useCount;
+
+  const BackgroundRenderer::Priority priority = idle ? BackgroundRenderer::Idle : BackgroundRenderer::Interactive;
+  if (id == BoardId)
+    BackgroundRenderer::instance()->render(handle(BoardId), documentKey(ThemeBundle::BoardBlob), document(ThemeBundle::BoardBlob), QString(), size, cacheKey(id, size), priority);
+  else
+    BackgroundRenderer::instance()->render(handle(id), documentKey(m_blobs.at(id)), document(m_blobs.at(id)), m_names.at(id), size, cacheKey(id, size), priority);
+}
+
+// The element rendered at the given size. If it is not rendered at that
+// size yet, the rendering used last is returned and the new one is queued;
+// null if the element was never rendered, it shows up once it is.
+QImage ElementCatalog::image(int id, const QSize &size)
+{
+  Rendering *cached = rendering(id, size);
+  if (cached)
+  {
+    cached->lastUsed = ++m_useCount;
+    return cached->image;
+  }
+
+  Rendering *latest = latestRendering(id);
+  queueRendering(id, size);
+  return latest ? latest->image : QImage();
+}
+
+// The whole board at the given size, the preview until it is rendered at
+// that size. Null if there is nothing to show yet.
+QImage ElementCatalog::boardImage(const QSize &size)
+{
+  Rendering *cached = rendering(BoardId, size);
+  if (cached)
+  {
+    cached->lastUsed = ++m_useCount;
+    return cached->image;
+  }
+
+  Rendering *latest = latestRendering(BoardId);
+  if (!latest && !m_preview.isNull())
+  {
+    latest = freeRendering(BoardId);
+    latest->image = m_preview;
+    latest->shared = false;
+    latest->lastUsed = ++m_useCount;
+  }
+
+  queueRendering(BoardId, size);
+  return latest ? latest->image : QImage();
+}
+
+// The element at the given size from the sprite cache, rendered and added
+// to it if it is not there yet. For drawing without the game, there is no
+// event loop to wait for the background renderer.
+QImage ElementCatalog::spriteImage(int id, const QSize &size)
+{
+  const QString key = cacheKey(id, size);
+  QImage image;
+  if (SpriteCache::find(key, &image) && image.size() == size)
+    return image;
+
+  image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+  image.fill(Qt::transparent);
+  QPainter painter(&image);
+  renderer(id)->render(&painter, m_names.at(id));
+  painter.end();
+
+  SpriteCache::insert(key, image);
+  return image;
+}
+
+// Store a rendering done by the background renderer. False if it is
+// already outdated; true as well if another view already stored it.
+bool ElementCatalog::setRendered(int id, const QImage &image, const QImage &mask, bool shared)
+{
+  if (rendering(id, image.size())) return true;
+
+  Rendering *kept = renderings(id);
+  for (int i = 0; i < RenderSlots; i++)
+  {
+    if (kept[i].pendingSize == image.size())
+    {
+      if (id != BoardId && m_masks.at(id).isNull())
+        m_masks[id] = mask;
+      kept[i].image = image;
+      kept[i].shared = shared;
+      kept[i].pendingSize = QSize();
+      kept[i].pendingIdle = false;
+      kept[i].lastUsed = ++m_useCount;
+      if (id == BoardId && m_preview.isNull())
+        savePreview(image);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Get the board ready to be shown at the given size before any view
+// shows it. True once it is; until then it is rendered at idle priority.
+bool ElementCatalog::prerender(const QSize &size)
+{
+  if (rendering(BoardId, size)) return true;
+
+  queueRendering(BoardId, size, true);
+  return false;
+}
+
+void ElementCatalog::clearRenderCache()
+{
+  m_renderings.fill(Rendering());
+  for (int i = 0; i < RenderSlots; i++)
+    m_boardRenderings[i] = Rendering();
+}
+
+void ElementCatalog::ref()
+{
+  m_refCount++;
+}
+
+// Once no view shows the playground, only keep what its items refer to
+void ElementCatalog::deref()
+{
+  Q_ASSERT(m_refCount > 0);
+  if (--m_refCount == 0)
+    releaseRenderData();
+}
+
+// What a rendering costs this process, those mapped from the sprite
+// cache are shared with the other sessions
+static qint64 privateBytes(const QImage &image, bool shared)
+{
+  return shared ? 0 : image.byteCount();
+}
+
+static qint64 sharedBytes(const QImage &image, bool shared)
+{
+  return shared ? image.byteCount() : 0;
+}
+
+// Whether a rendering can go: it is neither the one used last nor at
+// the size one of the views, given by their transformation, draws at
+bool ElementCatalog::isTrimmable(int id, int slot, const QList<QTransform> &views) const
+{
+  const Rendering *kept = renderings(id);
+  const QSize size = kept[slot].image.size();
+  if (size.isEmpty()) return false;
+
+  // the one used last is shown until the size wanted is rendered
+  bool latest = true;
+  for (int i = 0; i < RenderSlots; i++)
+  {
+    if (!kept[i].image.isNull() && kept[i].lastUsed > kept[slot].lastUsed) latest = false;
+  }
+  if (latest) return false;
+
+  const QSizeF unscaled = id == BoardId ? QSizeF(m_defaultSize) : scaledSize(id);
+  foreach(const QTransform &view, views)
+  {
+    // the items round their size on the device the same way
+    const QSize drawn = view.mapRect(QRectF(QPointF(0, 0), unscaled)).size().toSize();
+    if (qAbs(drawn.width() - size.width()) <= 1 && qAbs(drawn.height() - size.height()) <= 1) return false;
+  }
+  return true;
+}
+
+// Drop the renderings the views do not draw with. Sizes being rendered
+// stay queued, they are wanted.
+void ElementCatalog::trimRenderings(const QList<QTransform> &views)
+{
+  for (int id = 0; id < count(); id++)
+  {
+    Rendering *kept = renderings(id);
+    for (int i = 0; i < RenderSlots; i++)
+    {
+      if (isTrimmable(id, i, views)) kept[i].image = QImage();
+    }
+  }
+
+  for (int i = 0; i < RenderSlots; i++)
+  {
+    if (isTrimmable(BoardId, i, views)) m_boardRenderings[i].image = QImage();
+  }
+}
+
+qint64 ElementCatalog::trimmableBytes(const QList<QTransform> &views) const
+{
+  qint64 bytes = 0;
+  for (int id = 0; id < count(); id++)
+  {
+    for (int i = 0; i < RenderSlots; i++)
+    {
+      const Rendering &rendering = renderings(id)[i];
+      if (isTrimmable(id, i, views)) bytes += privateBytes(rendering.image, rendering.shared);
+    }
+  }
+  for (int i = 0; i < RenderSlots; i++)
+  {
+    const Rendering &rendering = m_boardRenderings[i];
+    if (isTrimmable(BoardId, i, views)) bytes += privateBytes(rendering.image, rendering.shared);
+  }
+  return bytes;
+}
+
+// The hit test masks are sampled again from the renderings on the next click
+void ElementCatalog::releaseMasks()
+{
+  m_masks.fill(QImage());
+}
+
+ElementCatalog::Usage ElementCatalog::memoryUsage() const
+{
+  Usage usage;
+  foreach(const Rendering &rendering, m_renderings)
+  {
+    usage.renderings += privateBytes(rendering.image, rendering.shared);
+    usage.shared += sharedBytes(rendering.image, rendering.shared);
+  }
+  for (int i = 0; i < RenderSlots; i++)
+  {
+    usage.renderings += privateBytes(m_boardRenderings[i].image, m_boardRenderings[i].shared);
+    usage.shared += sharedBytes(m_boardRenderings[i].image, m_boardRenderings[i].shared);
+  }
+
+  foreach(const QImage &mask, m_masks)
+    usage.masks += mask.byteCount();
+
+  if (m_parsed)
+    usage.documents += m_bundle ? m_bundle->blob(ThemeBundle::BoardBlob).size() : SvgCache::documentSize(m_sourceFile);
+  for (int id = 0; id < count(); id++)
+  {
+    if (m_fragmentRenderers.at(id))
+      usage.documents += m_bundle->blob(m_blobs.at(id)).size();
+  }
+
+  if (!m_bundle)
+    usage.svgCache = SvgCache::memoryUsage(m_sourceFile);
+  usage.preview = m_preview.byteCount();
+  return usage;
+}
+
+// Drop the parsed documents, renderings and masks, and the decompressed
+// board. They are built again from the tables, the bundle or the SVG file
+// when needed.
+void ElementCatalog::releaseRenderData()
+{
+  clearRenderCache();
+  if (!m_bundle)
+    SvgCache::release(m_sourceFile);
+
+  qDeleteAll(m_fragmentRenderers);
+  m_fragmentRenderers.fill(0);
+  releaseMasks();
+
+  if (m_parsed)
+  {
+    m_renderer.load(QByteArray());
+    m_parsed = false;
+  }
+
+  BackgroundRenderer::instance()->forget(m_index);
+}
+
+// While a view is being resized the renderings we have are stretched,
+// there is no point rendering every intermediate size. Each view resizing
+// holds rendering until it settles or the view is closed.
+void ElementCatalog::holdRendering()
+{
+  s_renderingHolds++;
+}
+
+void ElementCatalog::releaseRendering()
+{
+  Q_ASSERT(s_renderingHolds > 0);
+  s_renderingHolds--;
+}
+
+// The SVG data a blob of the bundle is rendered from, the whole document
+// for playgrounds without a bundle
+QByteArray ElementCatalog::document(int blob) const
+{
+  if (m_bundle) return m_bundle->blob(blob);
+  return SvgCache::document(m_sourceFile);
+}
+
+quint32 ElementCatalog::documentKey(int blob) const
+{
+  return (m_index << 16) | quint32(blob);
+}
+
+// Renderings of an older version of the file are not looked up
+void ElementCatalog::setSourceFile(const QString &sourceFile)
+{
+  m_sourceFile = sourceFile;
+  m_cacheKey = sourceFile + QLatin1Char( '@' ) + QString::number(QFileInfo(sourceFile).lastModified().toMSecsSinceEpoch());
+}
+
+// Not CacheLocation, the thumbnailer runs under another application name
+static QString previewFile(const QString &sourceFile)
+{
+  const QByteArray hash = QCryptographicHash::hash(sourceFile.toUtf8(), QCryptographicHash::Sha1).toHex();
+  return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String( "/ktuberling/previews/" ) + QString::fromLatin1(hash) + QLatin1String( ".png" );
+}
+
+// The low resolution board saved by an earlier session, if the
+// playground did not change since
+void ElementCatalog::loadPreview()
+{
+  const QFileInfo preview(previewFile(m_sourceFile));
+  if (preview.exists() && preview.lastModified() >= QFileInfo(m_sourceFile).lastModified())
+    m_preview.load(preview.filePath());
+}
+
+void ElementCatalog::savePreview(const QImage &board)
+{
+  const QString file = previewFile(m_sourceFile);
+  QDir().mkpath(QFileInfo(file).absolutePath());
+
+  QSaveFile saveFile(file);
+  if (!saveFile.open(QIODevice::WriteOnly)) return;
+  const QImage preview = board.scaledToWidth(qMin(PREVIEW_WIDTH, board.width()), Qt::SmoothTransformation);
+  if (preview.save(&saveFile, "PNG") && saveFile.commit())
+    m_preview = preview;
+}
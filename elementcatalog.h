@@ -0,0 +1,192 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Catalog of the elements of a playground */
+
+#ifndef _ELEMENTCATALOG_H_
+#define _ELEMENTCATALOG_H_
+
+#include <QHash>
+#include <QImage>
+#include <QRectF>
+#include <QSet>
+#include <QSvgRenderer>
+#include <QTransform>
+#include <QVector>
+
+class ThemeBundle;
+
+// Every element name of a playground is interned to a dense id when the
+// playground is loaded. Everything we need to know about an element sits
+// in arrays indexed by that id, so nothing but file loading looks
+// elements up by name.
+//
+// The objects of the warehouse are listed in the order of the .theme
+// file. The other elements are only used by objects read from files, or
+// were objects before the playground was reloaded.
+//
+// Objects on the board refer to their element with a 32 bit handle
+// that combines the catalog and the element id.
+//
+// When the playground was compiled into a bundle, the objects come from
+// the bundle and each one is rendered from its own small SVG fragment,
+// parsed the first time the object is drawn.
+//
+// Renderings at a new size are done by the background renderer. The last
+// rendering, or a low resolution preview of the board saved by an earlier
+// session, is shown meanwhile. The background renderer takes them from
+// the sprite cache shared with the other running instances when it can;
+// those are drawn straight from the mapped cache files. Renderings are
+// kept as images for that reason, drawing them is just as fast with the
+// raster paint engine.
+//
+// Catalogs are shared by every view showing the playground. A few
+// renderings are kept for each element, so views of different sizes do
+// not keep replacing each other's. Once no view uses the playground
+// any more, everything but its tables is released.
+class ElementCatalog
+{
+  public:
+    // ids are the lower half of the handles, the last one is the board's
+    enum { BoardId = 0xffff, MaxElements = BoardId };
+
+    // Bytes held, the parsed documents are counted by the size of their
+    // XML as QSvgRenderer does not tell what it keeps. The SVG cache
+    // holds the decompressed XML of a .svgz board. Shared renderings are
+    // mapped from the sprite cache, they are not part of the total.
+    class Usage
+    {
+      public:
+        Usage() : renderings(0), shared(0), masks(0), documents(0), svgCache(0), preview(0) {}
+        qint64 total() const { return renderings + masks + documents + svgCache + preview; }
+
+        qint64 renderings;
+        qint64 shared;
+        qint64 masks;
+        qint64 documents;
+        qint64 svgCache;
+        qint64 preview;
+    };
+
+    static ElementCatalog *forGameboard(const QString &gameboardFile);
+    static QStringList gameboards();
+    static ElementCatalog *fromHandle(quint32 handle);
+    static inline int idFromHandle(quint32 handle) { return handle & 0xffff; }
+
+    bool isLoaded() const;
+    bool load(const QString &svgFile);
+    bool loadBundle(const QString &bundleFile);
+    bool loadGameboard(const QString &gameboardFile, const QString &svgFile);
+    bool reload(const QString &gameboardFile, const QString &svgFile, const QSet<QString> &changed);
+
+    QSvgRenderer *renderer();
+    QSvgRenderer *renderer(int id);
+    QSize defaultSize() const;
+    QRectF backgroundRect() const;
+    QImage preview() const;
+
+    int addObject(const QString &name, const QString &sound, qreal scale);
+    int intern(const QString &name);
+    int find(const QString &name) const;
+
+    quint32 handle(int id) const;
+    int count() const;
+    int objectCount() const;
+    int objectId(int index) const;
+
+    int objectAt(const QPointF &scenePos) const;
+    bool opaqueAt(int id, qreal x, qreal y);
+    QImage mask(int id);
+
+    inline const QString &name(int id) const { return m_names.at(id); }
+    inline const QString &sound(int id) const { return m_sounds.at(id); }
+    inline const QRectF &bounds(int id) const { return m_bounds.at(id); }
+    inline qreal scale(int id) const { return m_scales.at(id); }
+    inline QSizeF scaledSize(int id) const { return m_bounds.at(id).size() * m_scales.at(id); }
+
+    QImage image(int id, const QSize &size);
+    QImage boardImage(const QSize &size);
+    QImage spriteImage(int id, const QSize &size);
+    bool setRendered(int id, const QImage &image, const QImage &mask, bool shared);
+    bool prerender(const QSize &size);
+    void clearRenderCache();
+
+    void ref();
+    void deref();
+    void releaseRenderData();
+    void trimRenderings(const QList<QTransform> &views);
+    qint64 trimmableBytes(const QList<QTransform> &views) const;
+    void releaseMasks();
+    Usage memoryUsage() const;
+
+    static void holdRendering();
+    static void releaseRendering();
+
+  private:
+    enum { RenderSlots = 4 };
+
+    class Rendering
+    {
+      public:
+        Rendering() : shared(false), pendingIdle(false), lastUsed(0) {}
+
+        QImage image;
+        bool shared;			// mapped from the sprite cache
+        QSize pendingSize;		// size being rendered in the background
+        bool pendingIdle;		// only when nothing else needs the processor
+        quint32 lastUsed;
+    };
+
+    explicit ElementCatalog(quint32 index);
+    ~ElementCatalog();
+    int append(const QString &name, const QString &sound, qreal scale, const QRectF &bounds, int blob);
+    int setObject(const QString &name, const QString &sound, qreal scale, const QRectF &bounds, int blob);
+    QByteArray document(int blob) const;
+    quint32 documentKey(int blob) const;
+    void setSourceFile(const QString &sourceFile);
+    void loadPreview();
+    void savePreview(const QImage &board);
+    Rendering *renderings(int id);
+    const Rendering *renderings(int id) const;
+    bool isTrimmable(int id, int slot, const QList<QTransform> &views) const;
+    Rendering *rendering(int id, const QSize &size);
+    Rendering *latestRendering(int id);
+    Rendering *freeRendering(int id);
+    QString cacheKey(int id, const QSize &size) const;
+    void queueRendering(int id, const QSize &size, bool idle = false);
+
+    quint32 m_index;			// position in the list of catalogs
+    int m_refCount;			// views showing the playground
+    bool m_loaded;
+    bool m_parsed;			// whether m_renderer holds the board
+    QString m_sourceFile;		// the bundle or SVG file
+    QString m_cacheKey;			// the source file in the sprite cache
+    QSvgRenderer m_renderer;
+    QSize m_defaultSize;
+    QRectF m_backgroundRect;
+    ThemeBundle *m_bundle;
+
+    QHash<QString, int> m_ids;		// only used when loading
+    QVector<QString> m_names;
+    QVector<QString> m_sounds;
+    QVector<QRectF> m_bounds;		// unscaled, in playground coordinates
+    QVector<qreal> m_scales;
+    QVector<int> m_blobs;		// fragment of the element in the bundle
+    QVector<int> m_objects;		// ids of the objects of the warehouse
+    QVector<QSvgRenderer *> m_fragmentRenderers;	// parsed when first drawn
+    QVector<Rendering> m_renderings;	// RenderSlots for each element
+    Rendering m_boardRenderings[RenderSlots];
+    quint32 m_useCount;			// orders the renderings by last use
+    QVector<QImage> m_masks;		// opaque pixels, from the first rendering
+    QImage m_preview;			// low resolution board
+
+    static int s_renderingHolds;	// views resizing, new sizes are not rendered while any is
+};
+
+#endif
@@ -0,0 +1,38 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Reads and writes whole files without blocking */
+
+#include "filetransfer.h"
+
+#include <kio/storedtransferjob.h>
+#include <kjobwidgets.h>
+
+KJob *FileTransfer::get(const QUrl &url, QWidget *window)
+{
+  KIO::StoredTransferJob *job = KIO::storedGet(url, KIO::NoReload, window ? KIO::DefaultFlags : KIO::HideProgressInfo);
+  if (window) KJobWidgets::setWindow(job, window);
+  return job;
+}
+
+// The file dialogs ask about overwriting already
+KJob *FileTransfer::put(const QByteArray &data, const QUrl &url, QWidget *window)
+{
+  KIO::JobFlags flags = KIO::Overwrite;
+  if (!window) flags |= KIO::HideProgressInfo;
+  KIO::StoredTransferJob *job = KIO::storedPut(data, url, -1, flags);
+  if (window) KJobWidgets::setWindow(job, window);
+  return job;
+}
+
+// What a finished get() read
+QByteArray FileTransfer::data(KJob *job)
+{
+  return static_cast<KIO::StoredTransferJob *>(job)->data();
+}
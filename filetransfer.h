@@ -0,0 +1,33 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Reads and writes whole files without blocking */
+
+#ifndef _FILETRANSFER_H_
+#define _FILETRANSFER_H_
+
+#include <QByteArray>
+#include <QUrl>
+
+class KJob;
+class QWidget;
+
+// Files are read into memory and written from it by KIO jobs, local or
+// remote alike: no temporary file, and nothing waits for them in a nested
+// event loop. The jobs report their result with KJob::result; with a
+// window, KIO shows their progress there and lets the user cancel them.
+class FileTransfer
+{
+  public:
+    static KJob *get(const QUrl &url, QWidget *window = 0);
+    static KJob *put(const QByteArray &data, const QUrl &url, QWidget *window = 0);
+    static QByteArray data(KJob *job);
+};
+
+#endif
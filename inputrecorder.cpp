@@ -0,0 +1,243 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Input recording and replaying for performance regression runs */
+
+#include "inputrecorder.h"
+
+#include <QApplication>
+#include <QBuffer>
+#include <QDataStream>
+#include <QFile>
+#include <QMouseEvent>
+#include <QTextStream>
+#include <QTimer>
+
+#include "playground.h"
+#include "toplevel.h"
+
+static const char *recordingMagic = "KTuberlingInputV1";
+
+namespace
+{
+  QFile recordingFile;
+  QDataStream recordingStream;
+  QElapsedTimer recordingClock;
+
+  void writeHeader(InputRecorder::RecordKind kind)
+  {
+    recordingStream << quint8(kind) << quint32(recordingClock.elapsed());
+  }
+}
+
+bool InputRecorder::s_recording = false;
+
+bool InputRecorder::start(const QString &fileName)
+{
+  recordingFile.setFileName(fileName);
+  if (!recordingFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  recordingStream.setDevice(&recordingFile);
+  recordingStream.setVersion(QDataStream::Qt_4_5);
+  recordingStream << QString::fromLatin1(recordingMagic);
+  recordingClock.start();
+  s_recording = true;
+  return true;
+}
+
+void InputRecorder::stop()
+{
+  if (!s_recording) return;
+
+  s_recording = false;
+  recordingStream.setDevice(0);
+  recordingFile.close();
+}
+
+void InputRecorder::recordMouse(QEvent::Type type, const QPointF &scenePos, Qt::MouseButton button, Qt::MouseButtons buttons, Qt::KeyboardModifiers modifiers)
+{
+  writeHeader(MouseRecord);
+  recordingStream << quint8(type == QEvent::MouseMove ? 0 : type == QEvent::MouseButtonPress ? 1 : 2)
+                  << scenePos << quint8(button) << quint8(buttons) << quint32(modifiers);
+}
+
+void InputRecorder::recordGameboard(const QString &board)
+{
+  writeHeader(GameboardRecord);
+  recordingStream << board;
+}
+
+void InputRecorder::recordLanguage(const QString &soundFile)
+{
+  writeHeader(LanguageRecord);
+  recordingStream << soundFile;
+}
+
+void InputRecorder::recordScene(PlayGround *playGround)
+{
+  QByteArray data;
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::WriteOnly);
+  if (!playGround->saveTo(&buffer)) return;
+
+  writeHeader(SceneRecord);
+  recordingStream << data;
+}
+
+
+
+void InputReplayer::PhaseTimes::add(qint64 nsecs)
+{
+  count++;
+  total += nsecs;
+  max = qMax(max, nsecs);
+}
+
+InputReplayer::InputReplayer(TopLevel *topLevel, bool fast)
+ : QObject(topLevel), m_topLevel(topLevel), m_fast(fast), m_next(0)
+{
+}
+
+bool InputReplayer::load(const QString &fileName)
+{
+  QFile f(fileName);
+  if (!f.open(QIODevice::ReadOnly)) return false;
+
+  QDataStream in(&f);
+  in.setVersion(QDataStream::Qt_4_5);
+
+  QString magic;
+  in >> magic;
+  if (magic != QLatin1String(recordingMagic)) return false;
+
+  m_records.clear();
+  while (!in.atEnd())
+  {
+    Record record;
+    in >> record.kind >> record.time;
+    if (record.kind == InputRecorder::MouseRecord)
+      in >> record.eventType >> record.scenePos >> record.button >> record.buttons >> record.modifiers;
+    else if (record.kind == InputRecorder::SceneRecord)
+      in >> record.scene;
+    else
+      in >> record.file;
+
+    if (in.status() != QDataStream::Ok) break;
+    m_records << record;
+  }
+
+  return !m_records.isEmpty();
+}
+
+// Recordings without a scene start from an empty board
+void InputReplayer::start()
+{
+  m_topLevel->currentPlayGround()->reset();
+  m_next = 0;
+  m_clock.start();
+  QTimer::singleShot(0, this, SLOT(replayNext()));
+}
+
+void InputReplayer::replayNext()
+{
+  if (m_next >= m_records.count())
+  {
+    report();
+    qApp->quit();
+    return;
+  }
+
+  dispatch(m_records.at(m_next));
+  m_next++;
+
+  int delay = 0;
+  if (!m_fast && m_next < m_records.count())
+    delay = qMax(qint64(0), m_records.at(m_next).time - m_clock.elapsed());
+  QTimer::singleShot(delay, this, SLOT(replayNext()));
+}
+
+void InputReplayer::dispatch(const Record &record)
+{
+  PlayGround *playGround = m_topLevel->currentPlayGround();
+  QElapsedTimer timer;
+  QString phase;
+
+  timer.start();
+  if (record.kind == InputRecorder::MouseRecord)
+  {
+    static const QEvent::Type types[] = { QEvent::MouseMove, QEvent::MouseButtonPress, QEvent::MouseButtonRelease };
+    static const char *names[] = { "mouse move", "mouse press", "mouse release" };
+    const int typeIndex = qMin(int(record.eventType), 2);
+
+    sendMouse(playGround, types[typeIndex], record.scenePos, Qt::MouseButton(record.button),
+              Qt::MouseButtons(record.buttons), Qt::KeyboardModifiers(record.modifiers));
+    phase = QLatin1String(names[typeIndex]);
+  }
+  else if (record.kind == InputRecorder::GameboardRecord)
+  {
+    m_topLevel->changeGameboard(record.file);
+    phase = QStringLiteral("gameboard change");
+  }
+  else if (record.kind == InputRecorder::LanguageRecord)
+  {
+    m_topLevel->changeLanguage(record.file);
+    phase = QStringLiteral("language change");
+  }
+  else if (record.kind == InputRecorder::SceneRecord)
+  {
+    QByteArray data = record.scene;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    playGround->loadFrom(&buffer);
+    phase = QStringLiteral("scene load");
+  }
+  else return;
+  m_phases[phase].add(timer.nsecsElapsed());
+
+  // paint synchronously so the rendering cost of the event is measured too
+  timer.restart();
+  playGround->viewport()->repaint();
+  m_phases[QStringLiteral("paint")].add(timer.nsecsElapsed());
+}
+
+// Deliver a mouse event to the playground as if it happened there
+void InputReplayer::sendMouse(PlayGround *playGround, QEvent::Type type, const QPointF &scenePos, Qt::MouseButton button, Qt::MouseButtons buttons, Qt::KeyboardModifiers modifiers)
+{
+  QMouseEvent event(type, playGround->mapFromScene(scenePos), button, buttons, modifiers);
+  QApplication::sendEvent(playGround->viewport(), &event);
+}
+
+void InputReplayer::report()
+{
+  QTextStream out(stdout);
+  out << "KTuberling replay of " << m_records.count() << " events in " << m_clock.elapsed() << " ms\n";
+  printPhases(out, m_phases);
+}
+
+void InputReplayer::printPhases(QTextStream &out, const QMap<QString, PhaseTimes> &phases)
+{
+  out << QStringLiteral("phase").leftJustified(20) << QStringLiteral("count").rightJustified(8)
+      << QStringLiteral("total ms").rightJustified(12) << QStringLiteral("mean ms").rightJustified(12)
+      << QStringLiteral("max ms").rightJustified(12) << '\n';
+
+  QMap<QString, PhaseTimes>::const_iterator it, itEnd;
+  it = phases.constBegin();
+  itEnd = phases.constEnd();
+  for ( ; it != itEnd; ++it)
+  {
+    const PhaseTimes &times = it.value();
+    out << it.key().leftJustified(20)
+        << QString::number(times.count).rightJustified(8)
+        << QString::number(times.total / 1000000.0, 'f', 3).rightJustified(12)
+        << QString::number(times.total / 1000000.0 / times.count, 'f', 3).rightJustified(12)
+        << QString::number(times.max / 1000000.0, 'f', 3).rightJustified(12) << '\n';
+  }
+  out.flush();
+}
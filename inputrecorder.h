@@ -0,0 +1,105 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Input recording and replaying for performance regression runs */
+
+#ifndef _INPUTRECORDER_H_
+#define _INPUTRECORDER_H_
+
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QMap>
+#include <QObject>
+#include <QPointF>
+#include <QVector>
+
+class QTextStream;
+
+class PlayGround;
+class TopLevel;
+
+// Logs the mouse events reaching the playground and the gameboard and
+// language changes asked by the user. Mouse positions are stored in scene
+// coordinates so a recording can be replayed with any window size. The
+// board the recording starts from, and any board loaded or cleared
+// meanwhile, is stored whole.
+class InputRecorder
+{
+  public:
+    enum RecordKind { MouseRecord = 1, GameboardRecord, LanguageRecord, SceneRecord };
+
+    static bool start(const QString &fileName);
+    static void stop();
+    static inline bool isRecording() { return s_recording; }
+
+    static void recordMouse(QEvent::Type type, const QPointF &scenePos, Qt::MouseButton button, Qt::MouseButtons buttons, Qt::KeyboardModifiers modifiers);
+    static void recordGameboard(const QString &board);
+    static void recordLanguage(const QString &soundFile);
+    static void recordScene(PlayGround *playGround);
+
+  private:
+    static bool s_recording;
+};
+
+// Feeds a recording back to the application, either at the recorded
+// speed or as fast as possible, and reports the time spent per phase
+class InputReplayer : public QObject
+{
+  Q_OBJECT
+
+  public:
+    class PhaseTimes
+    {
+      public:
+        PhaseTimes() : count(0), total(0), max(0) {}
+        void add(qint64 nsecs);
+
+        int count;
+        qint64 total;
+        qint64 max;
+    };
+
+    InputReplayer(TopLevel *topLevel, bool fast);
+
+    bool load(const QString &fileName);
+    void start();
+
+    static void sendMouse(PlayGround *playGround, QEvent::Type type, const QPointF &scenePos, Qt::MouseButton button, Qt::MouseButtons buttons, Qt::KeyboardModifiers modifiers = Qt::NoModifier);
+    static void printPhases(QTextStream &out, const QMap<QString, PhaseTimes> &phases);
+
+  private Q_SLOTS:
+    void replayNext();
+
+  private:
+    class Record
+    {
+      public:
+        quint8 kind;
+        quint32 time;		// ms since the recording started
+        quint8 eventType;
+        QPointF scenePos;
+        quint8 button;
+        quint8 buttons;
+        quint32 modifiers;
+        QString file;
+        QByteArray scene;		// as saved in a file
+    };
+
+    void dispatch(const Record &record);
+    void report();
+
+    TopLevel *m_topLevel;
+    bool m_fast;
+    QVector<Record> m_records;
+    int m_next;
+    QElapsedTimer m_clock;
+    QMap<QString, PhaseTimes> m_phases;
+};
+
+#endif
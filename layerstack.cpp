@@ -0,0 +1,130 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Stacking order of the objects of a playground */
+
+#include "layerstack.h"
+
+#include "todraw.h"
+
+// the background has z value 0, objects go from 1 upwards
+static const qreal BOTTOM = 0;
+
+LayerStack::LayerStack()
+ : m_normalized(true)
+{
+}
+
+void LayerStack::insert(ToDraw *item, qreal zValue)
+{
+  item->setZValue(zValue);
+  m_items.insert(zValue, item);
+  if (zValue != m_items.count()) m_normalized = false;
+}
+
+void LayerStack::bringToFront(ToDraw *item)
+{
+  remove(item);
+  const qreal top = m_items.isEmpty() ? BOTTOM : m_items.lastKey();
+  insert(item, top + 1);
+}
+
+// Put item just above below, at the very bottom if below is null
+void LayerStack::insertAbove(ToDraw *item, ToDraw *below)
+{
+  remove(item);
+
+  const qreal lower = below ? below->zValue() : BOTTOM;
+  QMap<qreal, ToDraw *>::const_iterator next = m_items.upperBound(lower);
+  const qreal upper = next == m_items.constEnd() ? lower + 2 : next.key();
+  qreal zValue = (lower + upper) / 2;
+
+  // no room left between the two, make some
+  if (zValue <= lower || zValue >= upper)
+  {
+    renormalize();
+    insertAbove(item, below);
+    return;
+  }
+
+  insert(item, zValue);
+}
+
+void LayerStack::remove(ToDraw *item)
+{
+  QMap<qreal, ToDraw *>::iterator it = m_items.find(item->zValue());
+  if (it != m_items.end() && it.value() == item)
+  {
+    // only taking the top one keeps the z values contiguous
+    if (it + 1 != m_items.end()) m_normalized = false;
+    m_items.erase(it);
+  }
+}
+
+void LayerStack::clear()
+{
+  m_items.clear();
+  m_normalized = true;
+}
+
+ToDraw *LayerStack::itemBelow(const ToDraw *item) const
+{
+  QMap<qreal, ToDraw *>::const_iterator it = m_items.constFind(item->zValue());
+  if (it == m_items.constEnd() || it == m_items.constBegin())
+    return 0;
+  --it;
+  return it.value();
+}
+
+// The topmost object drawn at that position, checked against the shape of
+// the objects. Cheap enough to be called on every mouse move.
+ToDraw *LayerStack::itemAt(const QPointF &scenePos) const
+{
+  QMap<qreal, ToDraw *>::const_iterator it = m_items.constEnd();
+  while (it != m_items.constBegin())
+  {
+    --it;
+    ToDraw *item = it.value();
+    if (item->isVisible() && item->contains(scenePos - item->pos()))
+      return item;
+  }
+  return 0;
+}
+
+// The objects from bottom to top
+QList<ToDraw *> LayerStack::items() const
+{
+  return m_items.values();
+}
+
+int LayerStack::count() const
+{
+  return m_items.count();
+}
+
+// Whether the z values are something else than 1..n
+bool LayerStack::needsRenormalization() const
+{
+  return !m_normalized;
+}
+
+void LayerStack::renormalize()
+{
+  const QList<ToDraw *> ordered = m_items.values();
+  m_items.clear();
+
+  qreal zValue = BOTTOM;
+  foreach (ToDraw *item, ordered)
+  {
+    zValue++;
+    if (item->zValue() != zValue) item->setZValue(zValue);
+    m_items.insert(zValue, item);
+  }
+  m_normalized = true;
+}
@@ -0,0 +1,51 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Stacking order of the objects of a playground */
+
+#ifndef _LAYERSTACK_H_
+#define _LAYERSTACK_H_
+
+#include <QList>
+#include <QMap>
+
+class QPointF;
+
+class ToDraw;
+
+// Keeps the objects of a playground ordered by their z value, the z value
+// of an object is its key in the stack. Changes are expressed relative to
+// other objects (to the front, just above that one), so they do not depend
+// on the actual z values, which can be renumbered 1..n at any time.
+class LayerStack
+{
+  public:
+    LayerStack();
+
+    void bringToFront(ToDraw *item);
+    void insertAbove(ToDraw *item, ToDraw *below);
+    void remove(ToDraw *item);
+    void clear();
+
+    ToDraw *itemBelow(const ToDraw *item) const;
+    ToDraw *itemAt(const QPointF &scenePos) const;
+    QList<ToDraw *> items() const;
+    int count() const;
+
+    bool needsRenormalization() const;
+    void renormalize();
+
+  private:
+    void insert(ToDraw *item, qreal zValue);
+
+    QMap<qreal, ToDraw *> m_items;	// z value -> object, bottom to top
+    bool m_normalized;			// z values are 1..n
+};
+
+#endif
@@ -12,13 +12,24 @@
 #include <KLocalizedString>
 
 #include <KAboutData>
+#include <KConfig>
 #include <KCrash>
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QCommandLineOption>
 #include <QDir>
+#include <QTemporaryDir>
 #include <KDBusService>
+#include <KMainWindow>
+#include "inputrecorder.h"
+#include "playground.h"
+#include "sessionjournal.h"
+#include "soakrunner.h"
+#include "startupprofiler.h"
 #include "toplevel.h"
+#include "tracer.h"
+
+#include <functional>
 
 static const char version[] = "1.0.0";
 
@@ -46,25 +57,126 @@ int main(int argc, char *argv[])
   parser.addVersionOption();
   parser.addHelpOption();
   parser.addOption(QCommandLineOption(QStringList() <<  QStringLiteral("+<tuberling-file>"), i18n("Potato to open")));
+  parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("profile-startup"), i18n("Print how long each startup phase takes and exit")));
+  parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("record"), i18n("Record the input to <file>"), QStringLiteral("file")));
+  parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("replay"), i18n("Replay the input recorded in <file>, report the timings and exit (use -platform offscreen to run headless)"), QStringLiteral("file")));
+  parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("replay-fast"), i18n("Replay as fast as possible instead of at the recorded speed")));
+  parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("soak"), i18n("Run random operations for <minutes>, report memory and latency drift and exit (use -platform offscreen to run headless)"), QStringLiteral("minutes")));
+  parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("soak-seed"), i18n("Seed of the random operations of --soak"), QStringLiteral("seed"), QStringLiteral("1")));
+  parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("soak-max-rss-growth"), i18n("Fail --soak if the resident memory grows by more than <MiB>"), QStringLiteral("MiB"), QStringLiteral("64")));
+  parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("soak-max-latency-growth"), i18n("Fail --soak if the mean operation latency grows by more than <factor>"), QStringLiteral("factor"), QStringLiteral("2")));
+  parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("watch-themes"), i18n("Reload the playgrounds when their files change")));
+  parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("trace"), i18n("Write input to paint timings to <file> as Chrome trace events"), QStringLiteral("file")));
 
   aboutData.setupCommandLine(&parser);
   parser.process(app);
   aboutData.processCommandLine(&parser);
 
-  KDBusService service;
+  // KTUBERLING_TRACE=<file> does the same as --trace <file>
+  if (parser.isSet(QStringLiteral("trace")))
+      Tracer::enable(parser.value(QStringLiteral("trace")));
+  else
+      Tracer::enable(QString::fromLocal8Bit(qgetenv("KTUBERLING_TRACE")));
+
+  if (parser.isSet(QStringLiteral("profile-startup")))
+      StartupProfiler::enable();
+
+  // Later launches hand their files over to the running instance, which
+  // has its playgrounds registered already. Profiling, replaying and
+  // watching the themes need an instance of their own.
+  const bool ownInstance = parser.isSet(QStringLiteral("profile-startup")) || parser.isSet(QStringLiteral("replay")) ||
+                           parser.isSet(QStringLiteral("record")) || parser.isSet(QStringLiteral("soak")) ||
+                           parser.isSet(QStringLiteral("watch-themes"));
+  KDBusService service(ownInstance ? KDBusService::Multiple : KDBusService::Unique);
+  if (ownInstance)
+      SessionJournal::setEnabled(false);
+  // Soak runs and replays switch playgrounds and languages thousands of
+  // times, none of which the user chose: they get a configuration of
+  // their own, gone when they exit
+  QTemporaryDir throwawayConfig;
+  if (parser.isSet(QStringLiteral("soak")) || parser.isSet(QStringLiteral("replay")))
+      KConfig::setMainConfigName(throwawayConfig.path() + QLatin1String("/ktuberlingrc"));
   TopLevel *toplevel=0;
 
   if (app.isSessionRestored())
       RESTORE(TopLevel)
   else {
-      toplevel = new TopLevel();
-      toplevel->show();
+      {
+          StartupPhase phase(QStringLiteral("TopLevel"));
+          toplevel = new TopLevel();
+      }
+      {
+          StartupPhase phase(QStringLiteral("show"));
+          toplevel->show();
+      }
+      if (parser.isSet(QStringLiteral("watch-themes")))
+          toplevel->watchThemes();
+
+      std::function<void()> startTool;
+      if (parser.isSet(QStringLiteral("replay")))
+      {
+          InputReplayer *replayer = new InputReplayer(toplevel, parser.isSet(QStringLiteral("replay-fast")));
+          if (!replayer->load(parser.value(QStringLiteral("replay"))))
+          {
+              qWarning("Could not read the input recording");
+              return 1;
+          }
+          startTool = [replayer]() { replayer->start(); };
+      }
+      else if (parser.isSet(QStringLiteral("soak")))
+      {
+          SoakRunner::Limits limits;
+          limits.rssGrowth = parser.value(QStringLiteral("soak-max-rss-growth")).toLongLong() * 1024 * 1024;
+          limits.latencyGrowth = parser.value(QStringLiteral("soak-max-latency-growth")).toDouble();
+          SoakRunner *runner = new SoakRunner(toplevel, parser.value(QStringLiteral("soak-seed")).toUInt(),
+                                              parser.value(QStringLiteral("soak")).toInt(), limits);
+          startTool = [runner]() { runner->start(); };
+      }
+      else if (parser.isSet(QStringLiteral("record")))
+      {
+          const QString recording = parser.value(QStringLiteral("record"));
+          startTool = [recording, toplevel]()
+          {
+              if (InputRecorder::start(recording))
+                  InputRecorder::recordScene(toplevel->currentPlayGround());
+              else
+                  qWarning("Could not write the input recording");
+          };
+      }
+
+      // recordings and replays start from the board of the file, once
+      // it is loaded
       if (parser.positionalArguments().count())
-          toplevel->open(QUrl::fromUserInput(parser.positionalArguments().at(0), QDir::currentPath()));
+          toplevel->open(QUrl::fromUserInput(parser.positionalArguments().at(0), QDir::currentPath()), startTool);
+      else if (startTool)
+          startTool();
+  }
 
+  if (!toplevel)
+      toplevel = qobject_cast<TopLevel *>(KMainWindow::memberList().value(0));
+  // a session saved without a window of ours restores nothing
+  if (!toplevel)
+  {
+      toplevel = new TopLevel();
+      toplevel->show();
   }
 
+  QObject::connect(&service, &KDBusService::activateRequested, toplevel,
+                   [&parser, toplevel](const QStringList &arguments, const QString &workingDirectory)
+  {
+      parser.parse(arguments);
+      foreach(const QString &file, parser.positionalArguments())
+          toplevel->openInNewView(QUrl::fromUserInput(file, workingDirectory));
+      toplevel->raise();
+      toplevel->activateWindow();
+  });
+
   app.setWindowIcon(QIcon::fromTheme(QStringLiteral("ktuberling")));
 
-  return app.exec();
+  const int result = app.exec();
+
+  InputRecorder::stop();
+  Tracer::dump();
+
+  return result;
 }
@@ -0,0 +1,194 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* What the playgrounds cost in memory */
+
+#include "memoryaccountant.h"
+
+#include <KConfigGroup>
+#include <KLocalizedString>
+#include <KSharedConfig>
+
+#include <QDBusConnection>
+#include <QFileInfo>
+#include <QHash>
+#include <QTextStream>
+#include <QTimer>
+
+#include "action.h"
+#include "elementcatalog.h"
+#include "playground.h"
+#include "todraw.h"
+#include "toplevel.h"
+
+static const int BUDGET_CHECK_INTERVAL = 5000;	// ms
+
+// Rough sizes, QGraphicsItem and QUndoCommand keep most of their state in
+// private objects
+static const qint64 ITEM_BYTES = sizeof(ToDraw) + 256;
+static const qint64 COMMAND_BYTES = sizeof(ActionMove) + 64;
+
+MemoryAccountant::MemoryAccountant(TopLevel *topLevel)
+ : QObject(topLevel), m_topLevel(topLevel), m_budget(0)
+{
+  m_budgetTimer = new QTimer(this);
+  m_budgetTimer->setInterval(BUDGET_CHECK_INTERVAL);
+  connect(m_budgetTimer, &QTimer::timeout, this, &MemoryAccountant::enforceBudget);
+
+  KConfigGroup config(KSharedConfig::openConfig(), "General");
+  setBudget(config.readEntry("MemoryBudget", 0) * qint64(1024 * 1024));
+
+  QDBusConnection::sessionBus().registerObject(QStringLiteral("/MemoryUsage"), this, QDBusConnection::ExportScriptableSlots);
+}
+
+QList<MemoryAccountant::Entry> MemoryAccountant::entries() const
+{
+  QList<Entry> result;
+  foreach(const QString &gameboard, ElementCatalog::gameboards())
+  {
+    const ElementCatalog::Usage usage = ElementCatalog::forGameboard(gameboard)->memoryUsage();
+    const QString name = QFileInfo(gameboard).fileName();
+    Entry entry;
+    entry.gameboard = name;
+    entry.shared = true;
+    entry.what = i18n("Shared renderings");
+    entry.bytes = usage.shared;
+    result << entry;
+    entry.shared = false;
+    entry.what = i18n("Renderings");
+    entry.bytes = usage.renderings;
+    result << entry;
+    entry.what = i18n("Hit masks");
+    entry.bytes = usage.masks;
+    result << entry;
+    entry.what = i18n("Parsed documents");
+    entry.bytes = usage.documents;
+    result << entry;
+    entry.what = i18n("Decompressed document");
+    entry.bytes = usage.svgCache;
+    result << entry;
+    entry.what = i18n("Preview");
+    entry.bytes = usage.preview;
+    result << entry;
+  }
+
+  foreach(const PlayGround *playGround, m_topLevel->playGrounds())
+  {
+    foreach(const PlayGround::SceneUsage &usage, playGround->sceneUsage())
+    {
+      Entry entry;
+      entry.gameboard = QFileInfo(usage.gameboard).fileName();
+      entry.shared = false;
+      entry.what = i18n("Stickers in view %1", playGround->view() + 1);
+      entry.bytes = usage.items * ITEM_BYTES;
+      result << entry;
+      entry.what = i18n("Undo history in view %1", playGround->view() + 1);
+      entry.bytes = usage.commands * COMMAND_BYTES + usage.detachedItems * ITEM_BYTES;
+      result << entry;
+    }
+  }
+  return result;
+}
+
+QString MemoryAccountant::report() const
+{
+  QString result;
+  QTextStream out(&result);
+  foreach(const Entry &entry, entries())
+    out << entry.gameboard << '\t' << entry.what << '\t' << entry.bytes << '\n';
+  out << "total" << '\t' << '\t' << totalBytes() << '\n';
+  if (m_budget > 0)
+    out << "budget" << '\t' << '\t' << m_budget << '\n';
+  out.flush();
+  return result;
+}
+
+qlonglong MemoryAccountant::totalBytes() const
+{
+  qint64 total = 0;
+  foreach(const Entry &entry, entries())
+  {
+    if (!entry.shared) total += entry.bytes;
+  }
+  return total;
+}
+
+qlonglong MemoryAccountant::budget() const
+{
+  return m_budget;
+}
+
+void MemoryAccountant::setBudget(qlonglong bytes)
+{
+  m_budget = qMax(qlonglong(0), bytes);
+  if (m_budget > 0)
+  {
+    m_budgetTimer->start();
+    enforceBudget();
+  }
+  else
+  {
+    m_budgetTimer->stop();
+  }
+}
+
+// The transformations of the views showing each catalog
+static QHash<ElementCatalog *, QList<QTransform> > shownCatalogs(const QList<PlayGround *> &playGrounds)
+{
+  QHash<ElementCatalog *, QList<QTransform> > shown;
+  foreach(const PlayGround *playGround, playGrounds)
+  {
+    if (playGround->catalog()) shown[playGround->catalog()] << playGround->transform();
+  }
+  return shown;
+}
+
+// What enforceBudget() could drop. The stickers, the undo history and
+// what the views draw with stay whatever they cost, so they do not count.
+static qint64 droppableBytes(const QHash<ElementCatalog *, QList<QTransform> > &shown)
+{
+  qint64 total = 0;
+  foreach(const QString &gameboard, ElementCatalog::gameboards())
+  {
+    ElementCatalog *catalog = ElementCatalog::forGameboard(gameboard);
+    const ElementCatalog::Usage usage = catalog->memoryUsage();
+    total += usage.masks;
+    if (shown.contains(catalog))
+      total += catalog->trimmableBytes(shown.value(catalog));
+    else
+      total += usage.renderings + usage.documents + usage.svgCache;
+  }
+  return total;
+}
+
+void MemoryAccountant::enforceBudget()
+{
+  if (m_budget <= 0) return;
+
+  const QHash<ElementCatalog *, QList<QTransform> > shown = shownCatalogs(m_topLevel->playGrounds());
+  if (droppableBytes(shown) <= m_budget) return;
+
+  foreach(const QString &gameboard, ElementCatalog::gameboards())
+  {
+    ElementCatalog *catalog = ElementCatalog::forGameboard(gameboard);
+    if (shown.contains(catalog)) continue;
+    catalog->releaseRenderData();
+    if (droppableBytes(shown) <= m_budget) return;
+  }
+
+  QHash<ElementCatalog *, QList<QTransform> >::const_iterator it;
+  for (it = shown.constBegin(); it != shown.constEnd(); ++it)
+  {
+    it.key()->trimRenderings(it.value());
+    if (droppableBytes(shown) <= m_budget) return;
+  }
+
+  for (it = shown.constBegin(); it != shown.constEnd(); ++it)
+    it.key()->releaseMasks();
+}
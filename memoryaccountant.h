@@ -0,0 +1,65 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* What the playgrounds cost in memory */
+
+#ifndef _MEMORYACCOUNTANT_H_
+#define _MEMORYACCOUNTANT_H_
+
+#include <QList>
+#include <QObject>
+#include <QString>
+
+class QTimer;
+
+class TopLevel;
+
+// Attributes the memory of the game to each playground: the renderings,
+// hit masks, parsed and decompressed documents and preview of its
+// catalog, and the stickers and undo history of its scene in every view.
+// Available over D-Bus as /MemoryUsage and in the memory usage dialog.
+//
+// With a budget set, the least valuable data is dropped first while what
+// can be dropped is over it: everything rendered for playgrounds no view
+// shows, then the renderings the views do not draw with, then the hit
+// masks. Stickers, undo history and the renderings at the sizes the views
+// draw at are never dropped and do not count against the budget.
+class MemoryAccountant : public QObject
+{
+  Q_OBJECT
+  Q_CLASSINFO("D-Bus Interface", "org.kde.ktuberling.MemoryUsage")
+
+  public:
+    class Entry
+    {
+      public:
+        QString gameboard;
+        QString what;
+        qint64 bytes;
+        bool shared;			// mapped from files every session uses, not in the totals
+    };
+
+    explicit MemoryAccountant(TopLevel *topLevel);
+
+    QList<Entry> entries() const;
+
+  public Q_SLOTS:
+    Q_SCRIPTABLE QString report() const;
+    Q_SCRIPTABLE qlonglong totalBytes() const;
+    Q_SCRIPTABLE qlonglong budget() const;
+    Q_SCRIPTABLE void setBudget(qlonglong bytes);
+    Q_SCRIPTABLE void enforceBudget();
+
+  private:
+    TopLevel *m_topLevel;
+    qint64 m_budget;			// bytes, 0 for none
+    QTimer *m_budgetTimer;
+};
+
+#endif
@@ -0,0 +1,93 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Debug dialog showing what the playgrounds cost in memory */
+
+#include "memorydialog.h"
+
+#include <KLocalizedString>
+
+#include <QDialogButtonBox>
+#include <QHash>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include "memoryaccountant.h"
+
+static QString kib(qint64 bytes)
+{
+  return QString::number(bytes / 1024.0, 'f', 1);
+}
+
+MemoryDialog::MemoryDialog(MemoryAccountant *accountant, QWidget *parent)
+ : QDialog(parent), m_accountant(accountant)
+{
+  setWindowTitle(i18n("Memory Usage"));
+  setAttribute(Qt::WA_DeleteOnClose);
+
+  m_tree = new QTreeWidget(this);
+  m_tree->setHeaderLabels(QStringList() << i18n("Playground") << i18n("KiB"));
+  m_tree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+  m_total = new QLabel(this);
+
+  QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+  QPushButton *refreshButton = buttons->addButton(i18n("Refresh"), QDialogButtonBox::ActionRole);
+  QPushButton *budgetButton = buttons->addButton(i18n("Enforce Budget"), QDialogButtonBox::ActionRole);
+  budgetButton->setEnabled(m_accountant->budget() > 0);
+  connect(refreshButton, &QPushButton::clicked, this, &MemoryDialog::refresh);
+  connect(budgetButton, &QPushButton::clicked, this, &MemoryDialog::enforceBudget);
+  connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+  QVBoxLayout *layout = new QVBoxLayout(this);
+  layout->addWidget(m_tree);
+  layout->addWidget(m_total);
+  layout->addWidget(buttons);
+  resize(480, 400);
+
+  refresh();
+}
+
+// One branch per playground, with its total
+void MemoryDialog::refresh()
+{
+  m_tree->clear();
+  QHash<QString, QTreeWidgetItem *> boards;
+  QHash<QString, qint64> boardTotals;
+  foreach(const MemoryAccountant::Entry &entry, m_accountant->entries())
+  {
+    QTreeWidgetItem *&board = boards[entry.gameboard];
+    if (!board)
+    {
+      board = new QTreeWidgetItem(m_tree, QStringList() << entry.gameboard);
+      board->setExpanded(true);
+    }
+    new QTreeWidgetItem(board, QStringList() << entry.what << kib(entry.bytes));
+    if (!entry.shared) boardTotals[entry.gameboard] += entry.bytes;
+  }
+
+  QHash<QString, QTreeWidgetItem *>::const_iterator it;
+  for (it = boards.constBegin(); it != boards.constEnd(); ++it)
+    it.value()->setText(1, kib(boardTotals.value(it.key())));
+  m_tree->sortItems(0, Qt::AscendingOrder);
+
+  const qint64 budget = m_accountant->budget();
+  if (budget > 0)
+    m_total->setText(i18n("Total: %1 KiB, budget: %2 KiB", kib(m_accountant->totalBytes()), kib(budget)));
+  else
+    m_total->setText(i18n("Total: %1 KiB, no budget", kib(m_accountant->totalBytes())));
+}
+
+void MemoryDialog::enforceBudget()
+{
+  m_accountant->enforceBudget();
+  refresh();
+}
@@ -0,0 +1,39 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Debug dialog showing what the playgrounds cost in memory */
+
+#ifndef _MEMORYDIALOG_H_
+#define _MEMORYDIALOG_H_
+
+#include <QDialog>
+
+class QLabel;
+class QTreeWidget;
+
+class MemoryAccountant;
+
+class MemoryDialog : public QDialog
+{
+  Q_OBJECT
+
+  public:
+    MemoryDialog(MemoryAccountant *accountant, QWidget *parent);
+
+  private Q_SLOTS:
+    void refresh();
+    void enforceBudget();
+
+  private:
+    MemoryAccountant *m_accountant;
+    QTreeWidget *m_tree;
+    QLabel *m_total;
+};
+
+#endif
@@ -21,30 +21,43 @@
 #include <QCursor>
 #include <QDataStream>
 #include <QDir>
-#include <QDomDocument>
-#include <QFile>
+#include <QIODevice>
 #include <QFileInfo>
-#include <QGraphicsSvgItem>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QPrinter>
+#include <QRubberBand>
 #include <QStandardPaths>
+#include <QSvgRenderer>
+#include <QTimer>
 
 #include <kstandardaction.h>
 #include <kactioncollection.h>
 #include <kstandardshortcut.h>
 
 #include "action.h"
+#include "backgroundrenderer.h"
+#include "boarditem.h"
+#include "elementcatalog.h"
+#include "inputrecorder.h"
+#include "layerstack.h"
+#include "savedgame.h"
+#include "savedhistory.h"
+#include "sessionjournal.h"
 #include "toplevel.h"
+#include "startupprofiler.h"
+#include "svgcache.h"
+#include "themebundle.h"
+#include "thememanifest.h"
 #include "todraw.h"
+#include "tracer.h"
 
-static const char *saveGameTextScaleTextMode = "KTuberlingSaveGameV2";
-static const char *saveGameTextTextMode = "KTuberlingSaveGameV3";
-static const char *saveGameText = "KTuberlingSaveGameV4";
+static const int RENORMALIZE_DELAY = 5000; // ms
+static const int RESIZE_DELAY = 200; // ms
 
 // Constructor
-PlayGround::PlayGround(TopLevel *parent)
-    : QGraphicsView(parent), m_newItem(0), m_dragItem(0), m_nextZValue(1), m_lockAspect(false)
+PlayGround::PlayGround(TopLevel *parent, int view)
+    : QGraphicsView(parent), m_catalog(0), m_view(view), m_newItem(0), m_dragItem(0), m_lockAspect(false), m_inputTimestamp(-1)
 {
   m_topLevel = parent;
   setFrameStyle(QFrame::NoFrame);
@@ -52,21 +65,45 @@ PlayGround::PlayGround(TopLevel *parent)
   setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   setMouseTracking(true);
+
+  m_journal = new SessionJournal(this, view);
+  m_rubberBand = new QRubberBand(QRubberBand::Rectangle, viewport());
+
+  m_renormalizeTimer.setSingleShot(true);
+  m_renormalizeTimer.setInterval(RENORMALIZE_DELAY);
+  connect(&m_renormalizeTimer, &QTimer::timeout, this, &PlayGround::renormalizeLayers);
+
+  m_resizeTimer.setSingleShot(true);
+  m_resizeTimer.setInterval(RESIZE_DELAY);
+  connect(&m_resizeTimer, &QTimer::timeout, this, &PlayGround::resizeSettled);
+
+  connect(BackgroundRenderer::instance(), &BackgroundRenderer::rendered, this, &PlayGround::elementRendered);
 }
 
 // Destructor
 PlayGround::~PlayGround()
 {
+  // a closed view has nothing to recover
+  m_journal->discard();
+
+  // closed while being resized
+  if (m_resizeTimer.isActive())
+    ElementCatalog::releaseRendering();
+
   foreach (const SceneData &data, m_scenes)
   {
     delete data.scene;
     delete data.undoStack;
+    delete data.layers;
+    data.catalog->deref();
   }
 }
 
 // Reset the play ground
 void PlayGround::reset()
 {
+  cancelDraggedGroup();
+  layers()->clear();
 
   foreach(QGraphicsItem *item, scene()->items())
   {
@@ -74,28 +111,41 @@ void PlayGround::reset()
     delete currentObject;
   }
 
+  m_scenes[m_gameboardFile].history.clear();
   undoStack()->clear();
+  setHover(QRectF());
+  m_journal->requestSnapshot();
 }
 
-// Save objects laid down on the editable area
-bool PlayGround::saveAs(const QString & name)
+// Save objects laid down on the editable area, followed by the undo
+// history if asked to. Files with a history have the number of objects
+// first, so readers know where the objects end.
+bool PlayGround::saveTo(QIODevice *device, bool withHistory)
 {
-  QFile f(name);
-  if (!f.open( QIODevice::WriteOnly ) )
-      return false;
+  const QList<ToDraw *> objects = stickers();
+  QByteArray history;
+  if (withHistory && undoStack()->count() > 0)
+  {
+    // a history not read yet is still the one of the file
+    history = m_scenes[m_gameboardFile].history;
+    if (history.isEmpty()) history = SavedHistory::save(undoStack(), objects);
+  }
 
   QFileInfo gameBoard(m_gameboardFile);
-  QDataStream out(&f);
+  QDataStream out(device);
   out.setVersion(QDataStream::Qt_4_5);
-  out << QString::fromLatin1(saveGameText);
+  out << SavedGame::magic(!history.isEmpty());
   out << gameBoard.fileName();
-  foreach(QGraphicsItem *item, scene()->items())
+  if (!history.isEmpty()) out << quint32(objects.count());
+  // store the stacking order as compact ranks
+  int rank = 1;
+  foreach(const ToDraw *currentObject, objects)
   {
-    ToDraw *currentObject = qgraphicsitem_cast<ToDraw *>(item);
-    if (currentObject != NULL) currentObject->save(out);
+    currentObject->save(out, rank++);
   }
+  if (!history.isEmpty()) out << history;
 
-  return (f.error() == QFile::NoError);
+  return (out.status() == QDataStream::Ok);
 }
 
 // Print gameboard's picture
@@ -122,99 +172,336 @@ QPixmap PlayGround::getPicture()
 
 void PlayGround::connectRedoAction(QAction *action)
 {
-  connect(action, &QAction::triggered, &m_undoGroup, &QUndoGroup::redo);
+  connect(action, &QAction::triggered, this, &PlayGround::redo);
+  connect(action, &QAction::triggered, m_journal, &SessionJournal::requestSnapshot);
+  connect(action, &QAction::triggered, &m_renormalizeTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
   connect(&m_undoGroup, &QUndoGroup::canRedoChanged, action, &QAction::setEnabled);
+  action->setEnabled(m_undoGroup.canRedo());
 }
 
 void PlayGround::connectUndoAction(QAction *action)
 {
-  connect(action, &QAction::triggered, &m_undoGroup, &QUndoGroup::undo);
+  connect(action, &QAction::triggered, this, &PlayGround::undo);
+  connect(action, &QAction::triggered, m_journal, &SessionJournal::requestSnapshot);
+  connect(action, &QAction::triggered, &m_renormalizeTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
   connect(&m_undoGroup, &QUndoGroup::canUndoChanged, action, &QAction::setEnabled);
+  action->setEnabled(m_undoGroup.canUndo());
+}
+
+// The window moved the action to another view
+void PlayGround::disconnectAction(QAction *action)
+{
+  action->disconnect(&m_undoGroup);
+  action->disconnect(this);
+  action->disconnect(m_journal);
+  action->disconnect(&m_renormalizeTimer);
+  m_undoGroup.disconnect(action);
 }
 
 // Mouse pressed event
 void PlayGround::mousePressEvent(QMouseEvent *event)
 {
+  if (InputRecorder::isRecording())
+    InputRecorder::recordMouse(event->type(), mapToScene(event->pos()), event->button(), event->buttons(), event->modifiers());
+
   if (m_gameboardFile.isEmpty()) return;
 
   if (event->button() != Qt::LeftButton) return;
 
+  TraceScope trace("mousePress");
+  if (Tracer::isEnabled()) m_inputTimestamp = Tracer::now();
+
+  setHover(QRectF());
+
   if (m_dragItem) placeDraggedItem(event->pos());
   else if (m_newItem) placeNewItem(event->pos());
+  else if (!m_dragGroup.isEmpty()) placeDraggedGroup();
   else
   {
+    // whatever the click changes goes on top of the history of the file
+    restoreHistory();
+
     // see if the user clicked on the warehouse of items
     QPointF scenePos = mapToScene(event->pos());
-    QMap<QString, QString>::const_iterator it, itEnd;
-    it = m_objectsNameSound.constBegin();
-    itEnd = m_objectsNameSound.constEnd();
-    QString foundElem;
-    QRectF bounds;
-    for( ; foundElem.isNull() && it != itEnd; ++it)
+    int foundElem;
     {
-      bounds = m_SvgRenderer.boundsOnElement(it.key());
-      if (bounds.contains(scenePos)) foundElem = it.key();
+      TraceScope traceHit("hitTest:warehouse");
+      foundElem = m_catalog->objectAt(scenePos);
     }
 
-    if (!foundElem.isNull())
+    if (foundElem >= 0)
     {
-      const double objectScale = m_objectsNameRatio.value(foundElem);
-      const QSizeF elementSize = m_SvgRenderer.boundsOnElement(foundElem).size() * objectScale;
-      QPointF itemPos = mapToScene(event->pos());
+      scene()->clearSelection();
+      const QSizeF elementSize = m_catalog->scaledSize(foundElem);
+      QPointF itemPos = scenePos;
       itemPos -= QPointF(elementSize.width()/2, elementSize.height()/2);
 
-      m_topLevel->playSound(m_objectsNameSound.value(foundElem));
+      m_topLevel->playSound(m_catalog->sound(foundElem));
 
-      m_newItem = new ToDraw;
+      m_newItem = new ToDraw(m_catalog->handle(foundElem));
       m_newItem->setBeingDragged(true);
       m_newItem->setPos(clipPos(itemPos, m_newItem));
-      m_newItem->setSharedRenderer(&m_SvgRenderer);
-      m_newItem->setElementId(foundElem);
-      m_newItem->setZValue(m_nextZValue);
-      m_nextZValue++;
-      m_newItem->scale(objectScale, objectScale);
-
-      scene()->addItem(m_newItem);
+      {
+        TraceScope traceUpdate("sceneUpdate:addItem");
+        scene()->addItem(m_newItem);
+        layers()->bringToFront(m_newItem);
+      }
       setCursor(Qt::BlankCursor);
     }
     else
     {
       // see if the user clicked on an already existent item
-      QGraphicsItem *dragItem = scene()->itemAt(mapToScene(event->pos()));
-      m_dragItem = qgraphicsitem_cast<ToDraw*>(dragItem);
-      if (m_dragItem)
+      ToDraw *clickedItem;
       {
-        QString elem = m_dragItem->elementId();
-
-        m_topLevel->playSound(m_objectsNameSound.value(elem));
+        TraceScope traceHit("hitTest:items");
+        clickedItem = layers()->itemAt(scenePos);
+      }
+      if (clickedItem && (event->modifiers() & Qt::ControlModifier))
+      {
+        clickedItem->setSelected(!clickedItem->isSelected());
+      }
+      else if (clickedItem && clickedItem->isSelected() && scene()->selectedItems().count() > 1)
+      {
+        pickUpGroup(clickedItem, scenePos);
+      }
+      else if (clickedItem)
+      {
+        scene()->clearSelection();
+        m_dragItem = clickedItem;
+        m_topLevel->playSound(m_catalog->sound(m_dragItem->elementIndex()));
         setCursor(Qt::BlankCursor);
         m_dragItem->setBeingDragged(true);
         m_itemDraggedPos = m_dragItem->pos();
 
-        const QSizeF elementSize = m_dragItem->transform().mapRect(m_dragItem->unclippedRect()).size();
+        const QSizeF elementSize = m_dragItem->unclippedRect().size();
         QPointF itemPos = mapToScene(event->pos());
         itemPos -= QPointF(elementSize.width()/2, elementSize.height()/2);
+        TraceScope traceUpdate("sceneUpdate:setPos");
         m_dragItem->setPos(clipPos(itemPos, m_dragItem));
       }
+      else
+      {
+        // select what the rubber band will cover
+        if (!(event->modifiers() & Qt::ControlModifier))
+          scene()->clearSelection();
+        m_rubberBandOrigin = event->pos();
+        m_rubberBand->setGeometry(QRect(m_rubberBandOrigin, QSize()));
+        m_rubberBand->show();
+      }
     }
   }
 }
 
 void PlayGround::mouseMoveEvent(QMouseEvent *event)
 {
+  if (InputRecorder::isRecording())
+    InputRecorder::recordMouse(event->type(), mapToScene(event->pos()), event->button(), event->buttons(), event->modifiers());
+
+  if (m_rubberBand->isVisible())
+  {
+    m_rubberBand->setGeometry(QRect(m_rubberBandOrigin, event->pos()).normalized());
+    return;
+  }
+
+  if (!m_newItem && !m_dragItem && m_dragGroup.isEmpty())
+  {
+    if (m_catalog) updateHover(mapToScene(event->pos()));
+    return;
+  }
+
+  TraceScope trace("mouseMove");
+  if (Tracer::isEnabled() && m_inputTimestamp < 0) m_inputTimestamp = Tracer::now();
+
   if (m_newItem) {
     QPointF itemPos = mapToScene(event->pos());
-    const QSizeF elementSize = m_newItem->transform().mapRect(m_newItem->unclippedRect()).size();
+    const QSizeF elementSize = m_newItem->unclippedRect().size();
     itemPos -= QPointF(elementSize.width()/2, elementSize.height()/2);
 
+    TraceScope traceUpdate("sceneUpdate:setPos");
     m_newItem->setPos(clipPos(itemPos, m_newItem));
   } else if (m_dragItem) {
     QPointF itemPos = mapToScene(event->pos());
-    const QSizeF elementSize = m_dragItem->transform().mapRect(m_dragItem->unclippedRect()).size();
+    const QSizeF elementSize = m_dragItem->unclippedRect().size();
     itemPos -= QPointF(elementSize.width()/2, elementSize.height()/2);
 
+    TraceScope traceUpdate("sceneUpdate:setPos");
     m_dragItem->setPos(clipPos(itemPos, m_dragItem));
+  } else {
+    TraceScope traceUpdate("sceneUpdate:moveGroup");
+    moveGroup(mapToScene(event->pos()));
+  }
+}
+
+void PlayGround::mouseReleaseEvent(QMouseEvent *event)
+{
+  if (InputRecorder::isRecording())
+    InputRecorder::recordMouse(event->type(), mapToScene(event->pos()), event->button(), event->buttons(), event->modifiers());
+
+  if (event->button() != Qt::LeftButton || !m_rubberBand->isVisible()) return;
+
+  m_rubberBand->hide();
+  const QRect rect = QRect(m_rubberBandOrigin, event->pos()).normalized();
+  foreach(QGraphicsItem *item, scene()->items(mapToScene(rect), Qt::IntersectsItemBoundingRect))
+  {
+    if (qgraphicsitem_cast<ToDraw *>(item))
+      item->setSelected(true);
+  }
+}
+
+void PlayGround::leaveEvent(QEvent *)
+{
+  setHover(QRectF());
+}
+
+// Highlight what a click would pick, in the same order mousePressEvent()
+// looks for it
+void PlayGround::updateHover(const QPointF &scenePos)
+{
+  TraceScope trace("hitTest:hover");
+
+  const int object = m_catalog->objectAt(scenePos);
+  if (object >= 0)
+  {
+    const QRectF &bounds = m_catalog->bounds(object);
+    setHover(bounds, bounds, m_catalog->mask(object));
+    return;
   }
+
+  ToDraw *item = layers()->itemAt(scenePos);
+  if (item)
+    setHover(item->boundingRect().translated(item->pos()), item->unclippedRect().translated(item->pos()), m_catalog->mask(item->elementIndex()));
+  else
+    setHover(QRectF());
+}
+
+// Highlight the shape of the element drawn over elementRect, within rect.
+// Until the element was rendered, and so has no mask, the rect itself.
+void PlayGround::setHover(const QRectF &rect, const QRectF &elementRect, const QImage &mask)
+{
+  if (rect == m_hoverRect && elementRect == m_hoverElementRect && mask.isNull() == m_hoverMask.isNull()) return;
+
+  // the outline is drawn around the rect
+  if (!m_hoverRect.isNull()) viewport()->update(mapFromScene(m_hoverRect).boundingRect().adjusted(-2, -2, 2, 2));
+  m_hoverRect = rect;
+  m_hoverElementRect = elementRect;
+  m_hoverMask = mask;
+  if (!m_hoverMask.isNull())
+  {
+    // the mask is tinted once, not on every paint
+    QColor color = palette().color(QPalette::Highlight);
+    color.setAlpha(112);
+    m_hoverMask.setColor(1, color.rgba());
+  }
+  if (!m_hoverRect.isNull()) viewport()->update(mapFromScene(m_hoverRect).boundingRect().adjusted(-2, -2, 2, 2));
+}
+
+void PlayGround::drawForeground(QPainter *painter, const QRectF &)
+{
+  if (m_hoverRect.isNull()) return;
+
+  painter->save();
+  if (m_hoverMask.isNull())
+  {
+    QColor color = palette().color(QPalette::Highlight);
+    painter->setPen(QPen(color, 0));
+    color.setAlpha(48);
+    painter->setBrush(color);
+    painter->drawRect(m_hoverRect);
+  }
+  else
+  {
+    painter->setClipRect(m_hoverRect);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+    painter->drawImage(m_hoverElementRect, m_hoverMask);
+  }
+  painter->restore();
+}
+
+// Pick up all the selected objects, they keep their relative positions
+// while following the mouse
+void PlayGround::pickUpGroup(ToDraw *clickedItem, const QPointF &scenePos)
+{
+  m_topLevel->playSound(m_catalog->sound(clickedItem->elementIndex()));
+  setCursor(Qt::ClosedHandCursor);
+
+  // hundreds of objects move on every mouse move, the index is
+  // rebuilt once when they are dropped
+  scene()->setItemIndexMethod(QGraphicsScene::NoIndex);
+
+  m_groupAnchor = scenePos;
+  m_groupRect = QRectF();
+  foreach(ToDraw *item, layers()->items())
+  {
+    if (!item->isSelected()) continue;
+
+    m_dragGroup << item;
+    m_groupOldPos << item->pos();
+    m_groupRect |= item->unclippedRect().translated(item->pos());
+    item->setBeingDragged(true);
+  }
+}
+
+void PlayGround::moveGroup(const QPointF &scenePos)
+{
+  // the whole group stays on the board
+  const QSize boardSize = m_catalog->defaultSize();
+  QPointF delta = scenePos - m_groupAnchor;
+  delta.setX(qMax(-m_groupRect.left(), qMin(boardSize.width() - m_groupRect.right(), delta.x())));
+  delta.setY(qMax(-m_groupRect.top(), qMin(boardSize.height() - m_groupRect.bottom(), delta.y())));
+
+  for (int i = 0; i < m_dragGroup.count(); i++)
+    m_dragGroup.at(i)->setPos(m_groupOldPos.at(i) + delta);
+}
+
+void PlayGround::placeDraggedGroup()
+{
+  foreach(ToDraw *item, m_dragGroup)
+    item->setBeingDragged(false);
+  scene()->setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+
+  undoStack()->push(new ActionMoveGroup(m_dragGroup, m_groupOldPos, scene(), layers()));
+  foreach(ToDraw *item, m_dragGroup)
+    m_journal->recordMove(item);
+
+  m_dragGroup.clear();
+  m_groupOldPos.clear();
+  setCursor(QCursor());
+  m_renormalizeTimer.start();
+}
+
+// Put a carried group back where it was picked up, before the board it
+// is on changes under it
+void PlayGround::cancelDraggedGroup()
+{
+  if (m_dragGroup.isEmpty()) return;
+
+  for (int i = 0; i < m_dragGroup.count(); i++)
+  {
+    m_dragGroup.at(i)->setPos(m_groupOldPos.at(i));
+    m_dragGroup.at(i)->setBeingDragged(false);
+  }
+  scene()->setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+
+  m_dragGroup.clear();
+  m_groupOldPos.clear();
+  setCursor(QCursor());
+}
+
+void PlayGround::paintEvent(QPaintEvent *event)
+{
+  {
+    TraceScope traceRender("render");
+    QGraphicsView::paintEvent(event);
+  }
+
+  // the frame that shows the result of the pending input is done
+  if (m_inputTimestamp >= 0)
+  {
+    Tracer::record("inputToPaint", m_inputTimestamp, Tracer::now());
+    m_inputTimestamp = -1;
+  }
+
+  if (StartupProfiler::isEnabled()) StartupProfiler::firstFrame();
 }
 
 bool PlayGround::insideBackground(const QSizeF &size, const QPointF &pos) const
@@ -224,55 +511,61 @@ bool PlayGround::insideBackground(const QSizeF &size, const QPointF &pos) const
 
 QPointF PlayGround::clipPos(const QPointF &p, ToDraw *item) const
 {
-  const qreal objectScale = m_objectsNameRatio.value(item->elementId());
+  const QSizeF itemSize = item->unclippedRect().size();
 
   QPointF res = p;
   res.setX(qMax(qreal(0), res.x()));
   res.setY(qMax(qreal(0), res.y()));
-  res.setX(qMin(m_SvgRenderer.defaultSize().width() - item->boundingRect().width() * objectScale, res.x()));
-  res.setY(qMin(m_SvgRenderer.defaultSize().height()- item->boundingRect().height() * objectScale, res.y()));
+  const QSize boardSize = m_catalog->defaultSize();
+  res.setX(qMin(boardSize.width() - itemSize.width(), res.x()));
+  res.setY(qMin(boardSize.height()- itemSize.height(), res.y()));
   return res;
 }
 
 QRectF PlayGround::backgroundRect() const
 {
-  return m_SvgRenderer.boundsOnElement(QStringLiteral( "background" ));
+  return m_catalog->backgroundRect();
 }
 
 void PlayGround::placeDraggedItem(const QPoint &pos)
 {
   QPointF itemPos = mapToScene(pos);
-  const QSizeF &elementSize = m_dragItem->transform().mapRect(m_dragItem->unclippedRect()).size();
+  const QSizeF &elementSize = m_dragItem->unclippedRect().size();
   itemPos -= QPointF(elementSize.width()/2, elementSize.height()/2);
 
   if (insideBackground(elementSize, itemPos))
   {
     m_dragItem->setBeingDragged(false);
-    undoStack()->push(new ActionMove(m_dragItem, m_itemDraggedPos, m_nextZValue, scene()));
-    m_nextZValue++;
+    undoStack()->push(new ActionMove(m_dragItem, m_itemDraggedPos, scene(), layers()));
+    m_journal->recordMove(m_dragItem);
   }
   else
   {
-    undoStack()->push(new ActionRemove(m_dragItem, m_itemDraggedPos, scene()));
+    m_journal->recordRemove(m_dragItem);
+    undoStack()->push(new ActionRemove(m_dragItem, m_itemDraggedPos, scene(), layers()));
   }
 
   setCursor(QCursor());
   m_dragItem = 0;
+  m_renormalizeTimer.start();
 }
 
 void PlayGround::placeNewItem(const QPoint &pos)
 {
-  const QSizeF elementSize = m_newItem->transform().mapRect(m_newItem->unclippedRect()).size();
+  const QSizeF elementSize = m_newItem->unclippedRect().size();
   QPointF itemPos = mapToScene(pos);
   itemPos -= QPointF(elementSize.width()/2, elementSize.height()/2);
   if (insideBackground(elementSize, itemPos))
   {
     m_newItem->setBeingDragged(false);
-    undoStack()->push(new ActionAdd(m_newItem, scene()));
+    undoStack()->push(new ActionAdd(m_newItem, scene(), layers()));
+    m_journal->recordAdd(m_newItem);
   } else {
-    m_newItem->deleteLater();
+    layers()->remove(m_newItem);
+    delete m_newItem;
   }
   m_newItem = 0;
+  m_renormalizeTimer.start();
   setCursor(QCursor());
 }
 
@@ -280,7 +573,9 @@ void PlayGround::recenterView()
 {
   // Cannot use sceneRect() because sometimes items get placed
   // with pos() outside rect (e.g. pizza theme)
-  fitInView(QRect(QPoint(0,0), m_SvgRenderer.defaultSize()),
+  if (!m_catalog) return;
+
+  fitInView(QRect(QPoint(0,0), m_catalog->defaultSize()),
       m_lockAspect ? Qt::KeepAspectRatio : Qt::IgnoreAspectRatio);
 }
 
@@ -294,11 +589,44 @@ QUndoStack *PlayGround::undoStack() const
   return m_scenes[m_gameboardFile].undoStack;
 }
 
+LayerStack *PlayGround::layers() const
+{
+  return m_scenes[m_gameboardFile].layers;
+}
+
+// A rendering done in the background is ready, show it if it is for us
+void PlayGround::elementRendered(quint32 target, const QImage &image, const QImage &mask, bool shared)
+{
+  ElementCatalog *catalog = ElementCatalog::fromHandle(target);
+  if (catalog->setRendered(ElementCatalog::idFromHandle(target), image, mask, shared) && catalog == m_catalog)
+    viewport()->update();
+}
+
+// Give compact z values back to the objects when nobody is looking
+void PlayGround::renormalizeLayers()
+{
+  if (m_newItem || m_dragItem || !m_dragGroup.isEmpty() || m_gameboardFile.isEmpty()) return;
+  if (!layers()->needsRenormalization()) return;
+
+  layers()->renormalize();
+  m_journal->requestSnapshot();
+}
+
 void PlayGround::resizeEvent(QResizeEvent *)
 {
+  // show what we have scaled, render again once the size settles
+  if (!m_resizeTimer.isActive())
+    ElementCatalog::holdRendering();
+  m_resizeTimer.start();
   recenterView();
 }
 
+void PlayGround::resizeSettled()
+{
+  ElementCatalog::releaseRendering();
+  viewport()->update();
+}
+
 void PlayGround::lockAspectRatio(bool lock)
 {
   if (m_lockAspect != lock)
@@ -329,67 +657,55 @@ void PlayGround::registerPlayGrounds()
 
   foreach(const QString &theme, list)
   {
-    QFile layoutFile(theme);
-    if (layoutFile.open(QIODevice::ReadOnly))
+    StartupPhase phase(QFileInfo(theme).fileName());
+    const ThemeManifest *manifest = ThemeManifest::get(theme);
+    if (manifest)
     {
-      QDomDocument layoutDocument;
-      if (layoutDocument.setContent(&layoutFile))
+      KConfig c( QStandardPaths::locate(QStandardPaths::AppDataLocation, QLatin1String( "pics/" ) + manifest->desktop ) );
+      KConfigGroup cg = c.group("KTuberlingTheme");
+      // compiled themes come with their thumbnail
+      QPixmap pixmap;
+      ThemeBundle bundle;
+      const QString svgFile = QStandardPaths::locate(QStandardPaths::AppDataLocation, QLatin1String( "pics/" ) + manifest->gameboard );
+      const QString bundleFile = ThemeBundle::fileFor(theme, svgFile);
+      if (!bundleFile.isEmpty() && bundle.open(bundleFile))
+        pixmap = QPixmap::fromImage(bundle.thumbnail());
+      if (pixmap.isNull())
       {
-        QString desktop = layoutDocument.documentElement().attribute(QStringLiteral( "desktop" ));
-        KConfig c( QStandardPaths::locate(QStandardPaths::AppDataLocation, QLatin1String( "pics/" ) + desktop ) );
-        KConfigGroup cg = c.group("KTuberlingTheme");
-        QString gameboard = layoutDocument.documentElement().attribute(QStringLiteral( "gameboard" ));
-        QPixmap pixmap(200,100);
+        pixmap = QPixmap(200,100);
         pixmap.fill(Qt::transparent);
-        playGroundPixmap(gameboard,pixmap);
-        m_topLevel->registerGameboard(cg.readEntry("Name"), theme, pixmap);
+        playGroundPixmap(manifest->gameboard,pixmap);
       }
+      m_topLevel->registerGameboard(cg.readEntry("Name"), theme, pixmap);
     }
   }
 }
 
 void PlayGround::playGroundPixmap(const QString &playgroundName, QPixmap &pixmap)
 {
-  m_SvgRenderer.load(QStandardPaths::locate(QStandardPaths::AppDataLocation, QLatin1String( "pics/" ) + playgroundName ));
+  QSvgRenderer renderer(SvgCache::document(QStandardPaths::locate(QStandardPaths::AppDataLocation, QLatin1String( "pics/" ) + playgroundName )));
   QPainter painter(&pixmap);
-  m_SvgRenderer.render(&painter,QStringLiteral( "background" ));
+  renderer.render(&painter,QStringLiteral( "background" ));
 }
 
 // Load background and draggable objects masks
 bool PlayGround::loadPlayGround(const QString &gameboardFile)
 {
-  QDomNodeList playGroundsList,
-               editableAreasList, objectsList,
-               gameAreasList, maskAreasList, soundNamesList, labelsList;
-  QDomElement playGroundElement,
-              editableAreaElement, objectElement,
-              gameAreaElement, maskAreaElement, soundNameElement, labelElement;
-  QDomAttr gameboardAttribute, masksAttribute,
-           leftAttribute, topAttribute, rightAttribute, bottomAttribute,
-           refAttribute;
-
-  QFile layoutFile(gameboardFile);
-  if (!layoutFile.open(QIODevice::ReadOnly)) return false;
+  cancelDraggedGroup();
 
-  QDomDocument layoutDocument;
-  if (!layoutDocument.setContent(&layoutFile)) return false;
+  // parsed only once per session
+  const ThemeManifest *manifest = ThemeManifest::get(gameboardFile);
+  if (!manifest) return false;
 
-  playGroundElement = layoutDocument.documentElement();
-
-  QString gameboardName = playGroundElement.attribute(QStringLiteral( "gameboard" ));
-
-  QColor bgColor = QColor(playGroundElement.attribute(QStringLiteral( "bgcolor" ), QStringLiteral( "#fff" ) ) );
+  QColor bgColor = QColor(manifest->bgColor);
   if (!bgColor.isValid())
     bgColor = Qt::white;
 
-  if (!m_SvgRenderer.load(QStandardPaths::locate(QStandardPaths::AppDataLocation, QLatin1String( "pics/" ) + gameboardName )))
+  if (manifest->objects.count() < 1)
     return false;
 
-  objectsList = playGroundElement.elementsByTagName(QStringLiteral( "object" ));
-  if (objectsList.count() < 1)
-    return false;
-
-  m_objectsNameSound.clear();
+  ElementCatalog *catalog = loadCatalog(gameboardFile);
+  if (!catalog) return false;
 
   // create scene data if needed
   if(!m_scenes.contains(gameboardFile))
@@ -397,122 +713,298 @@ bool PlayGround::loadPlayGround(const QString &gameboardFile)
     SceneData &data = m_scenes[gameboardFile];
     data.scene = new QGraphicsScene();
     data.undoStack = new QUndoStack();
+    data.layers = new LayerStack();
+    data.catalog = catalog;
+    catalog->ref();
 
-    QGraphicsSvgItem *background = new QGraphicsSvgItem();
+    BoardItem *background = new BoardItem(catalog);
     background->setPos(QPoint(0,0));
-    background->setSharedRenderer(&m_SvgRenderer);
     background->setZValue(0);
     data.scene->addItem(background);
 
     m_undoGroup.addStack(data.undoStack);
   }
 
-  for (int decoration = 0; decoration < objectsList.count(); decoration++)
-  {
-    objectElement = (const QDomElement &) objectsList.item(decoration).toElement();
-
-    const QString &objectName = objectElement.attribute(QStringLiteral( "name" ));
-    if (m_SvgRenderer.elementExists(objectName))
-    {
-      m_objectsNameSound.insert(objectName, objectElement.attribute(QStringLiteral( "sound" )));
-      m_objectsNameRatio.insert(objectName, objectElement.attribute(QStringLiteral( "scale" ), QStringLiteral( "1" )).toDouble());
-    }
-    else
-    {
-      qWarning() << objectName << "does not exist. Check" << gameboardFile;
-    }
-  }
-
   setBackgroundBrush(bgColor);
+  setHover(QRectF());
   m_gameboardFile = gameboardFile;
+  m_catalog = catalog;
   setScene(scene());
 
   recenterView();
 
   m_undoGroup.setActiveStack(undoStack());
 
+  m_journal->requestSnapshot();
+
   return true;
 }
 
+// The catalog of a playground was read again after its files changed.
+// The objects laid down keep their elements, and the undo history its
+// commands; only sizes, the background color and the renderings change.
+void PlayGround::gameboardReloaded(const QString &gameboardFile)
+{
+  if (!m_scenes.contains(gameboardFile)) return;
+
+  foreach(QGraphicsItem *item, m_scenes[gameboardFile].scene->items())
+  {
+    if (ToDraw *toDraw = qgraphicsitem_cast<ToDraw *>(item))
+      toDraw->elementChanged();
+    else if (BoardItem *board = dynamic_cast<BoardItem *>(item))
+      board->boardChanged();
+  }
+
+  if (gameboardFile == m_gameboardFile)
+  {
+    loadPlayGround(gameboardFile);
+    viewport()->update();
+  }
+}
+
+// The elements of a playground are only read the first time it is shown
+// or prerendered, from its bundle if it was compiled. Without a bundle
+// the whole SVG is parsed, which bundledOnly avoids.
+ElementCatalog *PlayGround::loadCatalog(const QString &gameboardFile, bool bundledOnly)
+{
+  const ThemeManifest *manifest = ThemeManifest::get(gameboardFile);
+  if (!manifest) return 0;
+
+  ElementCatalog *catalog = ElementCatalog::forGameboard(gameboardFile);
+  if (!catalog->isLoaded())
+  {
+    const QString svgFile = QStandardPaths::locate(QStandardPaths::AppDataLocation, QLatin1String( "pics/" ) + manifest->gameboard );
+    if (bundledOnly)
+    {
+      const QString bundleFile = ThemeBundle::fileFor(gameboardFile, svgFile);
+      if (bundleFile.isEmpty() || !catalog->loadBundle(bundleFile))
+        return 0;
+    }
+    else if (!catalog->loadGameboard(gameboardFile, svgFile))
+    {
+      return 0;
+    }
+  }
+  return catalog;
+}
+
+// The size the board of a playground would be drawn at in this view,
+// worked out the way recenterView() fits it
+QSize PlayGround::boardSize(const ElementCatalog *catalog) const
+{
+  // the margin QGraphicsView::fitInView() leaves
+  const QRectF viewRect = QRectF(viewport()->rect()).adjusted(2, 2, -2, -2);
+  const QSizeF size = catalog->defaultSize();
+  if (viewRect.isEmpty() || size.isEmpty()) return QSize();
+
+  qreal xratio = viewRect.width() / size.width();
+  qreal yratio = viewRect.height() / size.height();
+  if (m_lockAspect)
+    xratio = yratio = qMin(xratio, yratio);
+  return QSizeF(size.width() * xratio, size.height() * yratio).toSize();
+}
+
 QString PlayGround::currentGameboard() const
 {
   return m_gameboardFile;
 }
 
-// Load objects and lay them down on the editable area
-PlayGround::LoadError PlayGround::loadFrom(const QString &name)
+int PlayGround::view() const
+{
+  return m_view;
+}
+
+ElementCatalog *PlayGround::catalog() const
+{
+  return m_catalog;
+}
+
+// Commands in the undo stack of the current playground
+int PlayGround::undoCount() const
 {
-  QFile f(name);
-  if (!f.open(QIODevice::ReadOnly))
-      return OtherError;
+  return undoStack()->count();
+}
+
+// What each playground shown in this view so far keeps
+QList<PlayGround::SceneUsage> PlayGround::sceneUsage() const
+{
+  QList<SceneUsage> result;
+  QMap<QString, SceneData>::const_iterator it;
+  for (it = m_scenes.constBegin(); it != m_scenes.constEnd(); ++it)
+  {
+    SceneUsage usage;
+    usage.gameboard = it.key();
+    usage.items = it->layers->items().count();
+    usage.commands = it->undoStack->count();
+    usage.detachedItems = 0;
+    for (int i = 0; i < usage.commands; i++)
+    {
+      const QUndoCommand *command = it->undoStack->command(i);
+      const ActionAdd *add = dynamic_cast<const ActionAdd *>(command);
+      const ActionRemove *remove = dynamic_cast<const ActionRemove *>(command);
+      if ((add && add->ownsItem()) || (remove && remove->ownsItem()))
+        usage.detachedItems++;
+    }
+    result << usage;
+  }
+  return result;
+}
 
-  QDataStream in(&f);
-  in.setVersion(QDataStream::Qt_4_5);
+// The objects laid down on the current playground, from bottom to top
+QList<ToDraw *> PlayGround::stickers() const
+{
+  return layers()->items();
+}
+
+static bool zValueLessThan(const ToDraw *a, const ToDraw *b)
+{
+  return a->zValue() < b->zValue();
+}
 
-  bool scale = false;
-  bool reopenInTextMode = false;
-  QString magicText;
-  in >> magicText;
-  if ( QLatin1String( saveGameTextScaleTextMode ) == magicText) {
-      scale = true;
-      reopenInTextMode = true;
-  } else if (QLatin1String( saveGameTextTextMode ) == magicText) {
-      reopenInTextMode = true;
-  } else if ( QLatin1String( saveGameText ) != magicText) {
-      return OldFileVersionError;
+// Lay down objects that were read from a file, keeping their stacking
+// order. Each one can be undone, unless the file came with its history:
+// until the history is read, commands that do nothing stand for what can
+// be undone and for what can be redone.
+void PlayGround::addLoadedItems(QList<ToDraw *> items, const QByteArray &history)
+{
+  qStableSort(items.begin(), items.end(), zValueLessThan);
+  foreach(ToDraw *item, items)
+  {
+    scene()->addItem(item);
+    layers()->bringToFront(item);
+    if (history.isEmpty())
+      undoStack()->push(new ActionAdd(item, scene(), layers()));
   }
 
-  if (reopenInTextMode) {
-      f.close();
-      if (!f.open(QIODevice::ReadOnly | QIODevice::Text))
-        return OtherError;
-      in.setDevice(&f);
-      in.setVersion(QDataStream::Qt_4_5);
-      in >> magicText;
+  if (!history.isEmpty())
+  {
+    // a history that can not be read is replaced by undoable objects
+    quint32 index, count;
+    if (!SavedHistory::position(history, &index, &count))
+      index = count = 1;
+
+    if (index > 0)
+      undoStack()->push(new QUndoCommand());
+    if (index < count)
+    {
+      undoStack()->push(new QUndoCommand());
+      undoStack()->undo();
+    }
+    m_scenes[m_gameboardFile].history = history;
   }
+}
 
-  sceneRect();
+// Put the history read from the file in the undo stack, in place of the
+// commands standing for it. Done on the first undo, or before the first
+// change as new commands go on top of it.
+void PlayGround::restoreHistory()
+{
+  if (m_gameboardFile.isEmpty()) return;
 
-  if (in.atEnd())
-    return OtherError;
+  SceneData &data = m_scenes[m_gameboardFile];
+  if (data.history.isEmpty()) return;
+
+  TraceScope trace("restoreHistory");
+  const QByteArray history = data.history;
+  data.history.clear();
+  data.undoStack->clear();
+  if (!SavedHistory::restore(history, stickers(), m_catalog, data.scene, data.layers, data.undoStack))
+  {
+    // as for files without history, each object can be undone
+    foreach(ToDraw *item, stickers())
+      data.undoStack->push(new ActionAdd(item, data.scene, data.layers));
+  }
+}
+
+void PlayGround::undo()
+{
+  cancelDraggedGroup();
+  restoreHistory();
+  m_undoGroup.undo();
+}
+
+void PlayGround::redo()
+{
+  cancelDraggedGroup();
+  restoreHistory();
+  m_undoGroup.redo();
+}
 
+// Restore the board left behind by a session that crashed
+bool PlayGround::recoverSession()
+{
   QString board;
-  in >> board;
+  QList<SessionJournal::Item> items;
+  if (!m_journal->recover(board, items)) return false;
+
+  m_topLevel->changeGameboard(board, this);
+  if (m_gameboardFile != board) return false;
+
+  reset();
+  QList<ToDraw *> objects;
+  foreach(const SessionJournal::Item &item, items)
+  {
+    const int id = m_catalog->intern(item.element);
+    if (id < 0) continue;
+    ToDraw *obj = new ToDraw(m_catalog->handle(id));
+    obj->setPos(item.pos);
+    obj->setZValue(item.zValue);
+    objects << obj;
+  }
+  addLoadedItems(objects);
+
+  m_journal->requestSnapshot();
+  return true;
+}
+
+// Load objects and lay them down on the editable area
+// The device is read from the start again for files saved in text mode,
+// it has to be random access
+PlayGround::LoadError PlayGround::loadFrom(QIODevice *device)
+{
+  SavedGame saved;
+  const SavedGame::Result result = saved.read(device);
+  if (result == SavedGame::UnknownVersion)
+    return OldFileVersionError;
+
+  sceneRect();
+
+  if (saved.board.isEmpty())
+    return OtherError;
 
   qreal xFactor = 1.0;
   qreal yFactor = 1.0;
-  m_topLevel->changeGameboard(board);
+  m_topLevel->changeGameboard(saved.board, this);
 
   reset();
 
-  if (scale) {
-    QSize defaultSize = m_SvgRenderer.defaultSize();
+  if (saved.scaled) {
+    QSize defaultSize = m_catalog->defaultSize();
     QSize currentSize = size();
     xFactor = (qreal)defaultSize.width() / (qreal)currentSize.width();
     yFactor = (qreal)defaultSize.height() / (qreal)currentSize.height();
   }
 
-  while ( !in.atEnd() )
+  QList<ToDraw *> objects;
+  foreach (const SavedGame::Sticker &sticker, saved.stickers)
   {
-    ToDraw *obj = new ToDraw;
-    if (!obj->load(in))
-    {
-      delete obj;
-      return OtherError;
-    }
-    obj->setSharedRenderer(&m_SvgRenderer);
-    double objectScale = m_objectsNameRatio.value(obj->elementId());
-    obj->scale(objectScale, objectScale);
-    if (scale) { // Mimic old behavior
-      QPointF storedPos = obj->pos();
+    const int id = m_catalog->intern(sticker.element);
+    if (id < 0) continue;
+    ToDraw *obj = new ToDraw(m_catalog->handle(id));
+    QPointF storedPos = sticker.pos;
+    if (saved.scaled) { // Mimic old behavior
       storedPos.setX(storedPos.x() * xFactor);
       storedPos.setY(storedPos.y() * yFactor);
-      obj->setPos(storedPos);
     }
-    scene()->addItem(obj);
-    undoStack()->push(new ActionAdd(obj, scene()));
+    obj->setPos(storedPos);
+    obj->setZValue(sticker.zValue);
+    objects << obj;
   }
-  if (f.error() == QFile::NoError) return NoError;
+
+  // the history is only read when the user goes back in it
+  addLoadedItems(objects, saved.history);
+
+  if (result == SavedGame::Read) return NoError;
   else return OtherError;
 }
 
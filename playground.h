@@ -14,52 +14,89 @@
 #define _PLAYGROUND_H_
 
 #include <QGraphicsView>
+#include <QImage>
 #include <QMap>
+#include <QTimer>
 
-#include <QSvgRenderer>
 #include <QUndoGroup>
 
 class KActionCollection;
 
 class Action;
+class ElementCatalog;
+class LayerStack;
+class SessionJournal;
 class ToDraw;
 class TopLevel;
+class QIODevice;
 class QPrinter;
-class QGraphicsSvgItem;
+class QRubberBand;
 
 class PlayGround : public QGraphicsView
 {
   Q_OBJECT
 
 public:
-  explicit PlayGround(TopLevel *parent);
+  PlayGround(TopLevel *parent, int view);
   ~PlayGround();
 
   enum LoadError { NoError, OldFileVersionError, OtherError };
 
+  class SceneUsage
+  {
+    public:
+      QString gameboard;
+      int items;					// on the board
+      int commands;					// in the undo stack
+      int detachedItems;				// off the board, kept for undo or redo
+  };
+
   void reset();
-  LoadError loadFrom(const QString &name);
-  bool saveAs(const QString &name);
+  LoadError loadFrom(QIODevice *device);
+  bool saveTo(QIODevice *device, bool withHistory = false);
   bool printPicture(QPrinter &printer);
   QPixmap getPicture();
 
   void connectRedoAction(QAction *action);
   void connectUndoAction(QAction *action);
+  void disconnectAction(QAction *action);
 
   void registerPlayGrounds();
   bool loadPlayGround(const QString &gameboardFile);
+  void gameboardReloaded(const QString &gameboardFile);
+  static ElementCatalog *loadCatalog(const QString &gameboardFile, bool bundledOnly = false);
+  QSize boardSize(const ElementCatalog *catalog) const;
 
   QString currentGameboard() const;
+  int view() const;
+  ElementCatalog *catalog() const;
+  int undoCount() const;
+  QList<SceneUsage> sceneUsage() const;
+  QList<ToDraw *> stickers() const;
+
+  void addLoadedItems(QList<ToDraw *> items, const QByteArray &history = QByteArray());
+  bool recoverSession();
 
   bool isAspectRatioLocked() const;
 
 public Q_SLOTS:
   void lockAspectRatio(bool lock);
+  void undo();
+  void redo();
+
+private Q_SLOTS:
+  void elementRendered(quint32 target, const QImage &image, const QImage &mask, bool shared);
+  void renormalizeLayers();
+  void resizeSettled();
 
 protected:
 
   void mousePressEvent(QMouseEvent *event);
   void mouseMoveEvent(QMouseEvent *event);
+  void mouseReleaseEvent(QMouseEvent *event);
+  void leaveEvent(QEvent *event);
+  void drawForeground(QPainter *painter, const QRectF &rect);
+  void paintEvent(QPaintEvent *event);
   void resizeEvent(QResizeEvent *event);
 
 private:
@@ -68,33 +105,55 @@ private:
   bool insideBackground(const QSizeF &size, const QPointF &pos) const;
   void placeDraggedItem(const QPoint &pos);
   void placeNewItem(const QPoint &pos);
+  void updateHover(const QPointF &scenePos);
+  void setHover(const QRectF &rect, const QRectF &elementRect = QRectF(), const QImage &mask = QImage());
+  void pickUpGroup(ToDraw *clickedItem, const QPointF &scenePos);
+  void moveGroup(const QPointF &scenePos);
+  void placeDraggedGroup();
+  void cancelDraggedGroup();
+  void restoreHistory();
   void playGroundPixmap(const QString &playgroundName, QPixmap &pixmap);
 
   void recenterView();
   
   QGraphicsScene *scene() const;
   QUndoStack *undoStack() const;
+  LayerStack *layers() const;
 
   QString m_gameboardFile;				// the file the board
-  QMap<QString, QString> m_objectsNameSound;		// map between element name and sound
-  QMap<QString, double> m_objectsNameRatio;		// map between element name and scaling ratio
+  ElementCatalog *m_catalog;				// the elements of the board
 
   TopLevel *m_topLevel;					// Top-level window
+  int m_view;						// number of the view in the window
 
   QPointF m_itemDraggedPos;
   ToDraw *m_newItem;				    // the new item we are moving
   ToDraw *m_dragItem;					// the existing item we are dragging
-  QSvgRenderer m_SvgRenderer;				// the SVG renderer
-  int m_nextZValue;					// the next Z value to use
+  QList<ToDraw *> m_dragGroup;				// the selected items we are dragging, bottom to top
+  QList<QPointF> m_groupOldPos;				// where they were picked up
+  QPointF m_groupAnchor;				// where the mouse picked them up
+  QRectF m_groupRect;					// what they covered when picked up
+  QRectF m_hoverRect;					// what a click would pick
+  QRectF m_hoverElementRect;				// the mask spans it
+  QImage m_hoverMask;					// tinted shape of the element, null for a rect
+  QRubberBand *m_rubberBand;
+  QPoint m_rubberBandOrigin;
+  QTimer m_renormalizeTimer;				// compacts the z values when idle
+  QTimer m_resizeTimer;					// fires once resizing settles
 
   bool m_lockAspect;					// whether we are locking aspect ratio
+  qint64 m_inputTimestamp;				// when the last traced input event arrived, -1 if none
   QUndoGroup m_undoGroup;
+  SessionJournal *m_journal;				// what to recover after a crash
   
   class SceneData
   {
     public:
       QGraphicsScene *scene;
       QUndoStack *undoStack;
+      LayerStack *layers;				// the stacking order of the objects
+      ElementCatalog *catalog;				// shared with the other views
+      QByteArray history;				// read from the file, not in the undo stack yet
   };
   QMap <QString, SceneData> m_scenes;  // caches the items of each playground
 };
@@ -0,0 +1,82 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* The .tuberling file format */
+
+#include "savedgame.h"
+
+#include <QDataStream>
+#include <QIODevice>
+
+static const char *saveGameTextScaleTextMode = "KTuberlingSaveGameV2";
+static const char *saveGameTextTextMode = "KTuberlingSaveGameV3";
+static const char *saveGameText = "KTuberlingSaveGameV4";
+static const char *saveGameTextHistory = "KTuberlingSaveGameV5";
+
+SavedGame::SavedGame()
+ : scaled(false)
+{
+}
+
+// The magic string to save with
+QString SavedGame::magic(bool withHistory)
+{
+  return QString::fromLatin1(withHistory ? saveGameTextHistory : saveGameText);
+}
+
+// Read a saved playground. The device is read from the start again for
+// files saved in text mode, it has to be random access. The board is
+// empty if the file ended before it.
+SavedGame::Result SavedGame::read(QIODevice *device, bool readHistory)
+{
+  QDataStream in(device);
+  in.setVersion(QDataStream::Qt_4_5);
+
+  bool reopenInTextMode = false;
+  bool withHistory = false;
+  QString magicText;
+  in >> magicText;
+  if ( QLatin1String( saveGameTextScaleTextMode ) == magicText) {
+      scaled = true;
+      reopenInTextMode = true;
+  } else if (QLatin1String( saveGameTextTextMode ) == magicText) {
+      reopenInTextMode = true;
+  } else if (QLatin1String( saveGameTextHistory ) == magicText) {
+      withHistory = true;
+  } else if ( QLatin1String( saveGameText ) != magicText) {
+      return UnknownVersion;
+  }
+
+  if (reopenInTextMode) {
+      if (!device->reset())
+        return Unreadable;
+      device->setTextModeEnabled(true);
+      in.resetStatus();
+      in >> magicText;
+  }
+
+  if (in.atEnd())
+    return Unreadable;
+
+  in >> board;
+
+  quint32 count = 0;
+  if (withHistory) in >> count;
+
+  while (in.status() == QDataStream::Ok && (withHistory ? quint32(stickers.count()) < count : !in.atEnd()))
+  {
+    Sticker sticker;
+    in >> sticker.pos >> sticker.element >> sticker.zValue;
+    if (in.status() == QDataStream::Ok) stickers << sticker;
+  }
+
+  if (withHistory && readHistory) in >> history;
+
+  return in.status() == QDataStream::Ok ? Read : Unreadable;
+}
@@ -0,0 +1,53 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* The .tuberling file format */
+
+#ifndef _SAVEDGAME_H_
+#define _SAVEDGAME_H_
+
+#include <QByteArray>
+#include <QList>
+#include <QPointF>
+#include <QString>
+
+class QIODevice;
+
+// What PlayGround::saveTo() writes: a magic string, the file name of the
+// playground, the stickers as ToDraw::save() writes them and, since V5,
+// their count before them and the undo history after them. Files of V2
+// and V3 were written in text mode, V2 with positions for the size the
+// window had.
+//
+// Shared by the game and the thumbnailer, which skips the history.
+class SavedGame
+{
+  public:
+    class Sticker
+    {
+      public:
+        QPointF pos;
+        QString element;
+        qreal zValue;
+    };
+
+    enum Result { Read, UnknownVersion, Unreadable };
+
+    SavedGame();
+
+    Result read(QIODevice *device, bool readHistory = true);
+    static QString magic(bool withHistory);
+
+    QString board;
+    bool scaled;			// positions of a V2 file
+    QList<Sticker> stickers;		// as far as they could be read
+    QByteArray history;
+};
+
+#endif
@@ -0,0 +1,468 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Undo history kept in saved files */
+
+#include "savedhistory.h"
+
+#include <QHash>
+#include <QStringList>
+#include <QUndoStack>
+#include <QVector>
+
+#include "action.h"
+#include "elementcatalog.h"
+#include "todraw.h"
+
+static const quint32 FORMAT_VERSION = 1;
+
+// Fixed point units of the positions: objects are placed in scene pixels,
+// commands keep fractions of the scene size
+static const qreal POSITION_UNITS = 64;
+static const qreal FRACTION_UNITS = 1 << 20;
+
+enum CommandType { AddCommand = 1, RemoveCommand, MoveCommand, MoveGroupCommand };
+
+namespace
+{
+  class HistoryWriter
+  {
+    public:
+      void writeNumber(quint64 value);
+      void writeSigned(qint64 value);
+      void writeString(const QString &string);
+      void writePoint(const QPointF &point, qreal units, qint64 *last);
+
+      QByteArray data;
+  };
+
+  class HistoryReader
+  {
+    public:
+      explicit HistoryReader(const QByteArray &data) : m_data(data), m_pos(0), m_ok(true) {}
+
+      quint32 readNumber();
+      qint64 readSigned();
+      QString readString();
+      QPointF readPoint(qreal units, qint64 *last);
+
+      // whether that many entries of at least a byte each can follow
+      inline bool canHold(quint32 count) const { return m_ok && count <= quint32(m_data.size() - m_pos); }
+      inline bool ok() const { return m_ok; }
+      inline bool atEnd() const { return m_pos == m_data.size(); }
+
+    private:
+      quint64 readVarint();
+
+      const QByteArray &m_data;
+      int m_pos;
+      bool m_ok;
+  };
+
+  // A command as read from the file, before anything is created
+  class StoredCommand
+  {
+    public:
+      int type;
+      QVector<quint32> items;
+      QVector<quint32> below;		// number of the object + 1, 0 for the bottom
+      QVector<QPointF> oldPos;
+      QVector<QPointF> newPos;
+  };
+}
+
+// Seven bits per byte, the high bit tells whether more follow
+void HistoryWriter::writeNumber(quint64 value)
+{
+  while (value >= 0x80)
+  {
+    data += char((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  data += char(value);
+}
+
+// Small differences either way stay small
+void HistoryWriter::writeSigned(qint64 value)
+{
+  writeNumber((quint64(value) << 1) ^ quint64(value >> 63));
+}
+
+void HistoryWriter::writeString(const QString &string)
+{
+  const QByteArray utf8 = string.toUtf8();
+  writeNumber(utf8.size());
+  data += utf8;
+}
+
+void HistoryWriter::writePoint(const QPointF &point, qreal units, qint64 *last)
+{
+  const qint64 x = qRound64(point.x() * units);
+  const qint64 y = qRound64(point.y() * units);
+  writeSigned(x - last[0]);
+  writeSigned(y - last[1]);
+  last[0] = x;
+  last[1] = y;
+}
+
+quint64 HistoryReader::readVarint()
+{
+  quint64 value = 0;
+  for (int shift = 0; shift < 64; shift += 7)
+  {
+    if (m_pos >= m_data.size()) break;
+    const uchar byte = m_data.at(m_pos++);
+    value |= quint64(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) return value;
+  }
+  m_ok = false;
+  return 0;
+}
+
+quint32 HistoryReader::readNumber()
+{
+  const quint64 value = readVarint();
+  if (value > 0xffffffff) m_ok = false;
+  return m_ok ? quint32(value) : 0;
+}
+
+qint64 HistoryReader::readSigned()
+{
+  const quint64 value = readVarint();
+  return qint64(value >> 1) ^ -qint64(value & 1);
+}
+
+QString HistoryReader::readString()
+{
+  const quint32 size = readNumber();
+  if (!canHold(size))
+  {
+    m_ok = false;
+    return QString();
+  }
+  const QString string = QString::fromUtf8(m_data.constData() + m_pos, size);
+  m_pos += size;
+  return string;
+}
+
+QPointF HistoryReader::readPoint(qreal units, qint64 *last)
+{
+  last[0] += readSigned();
+  last[1] += readSigned();
+  return QPointF(last[0] / units, last[1] / units);
+}
+
+// Whether the commands can be done and undone with the objects on the
+// board when the history was saved: each object is added and removed at
+// most once, in that order, only moved while on the board, and exactly
+// one of the board and the commands owns it at any point
+static bool consistent(const QVector<StoredCommand> &commands, quint32 index, quint32 boardCount, quint32 itemCount)
+{
+  QVector<int> added(itemCount, -1);
+  QVector<int> removed(itemCount, -1);
+  for (int i = 0; i < commands.count(); i++)
+  {
+    const StoredCommand &command = commands.at(i);
+    if (command.type == AddCommand || command.type == RemoveCommand)
+    {
+      int &at = command.type == AddCommand ? added[command.items.first()] : removed[command.items.first()];
+      if (at >= 0) return false;
+      at = i;
+    }
+  }
+
+  for (quint32 item = 0; item < itemCount; item++)
+  {
+    const int add = added.at(item);
+    const int remove = removed.at(item);
+    if (add >= 0 && remove >= 0 && remove < add) return false;
+
+    // on the board from the add to the remove; objects without either
+    // are on the board all along
+    const bool onBoard = (add < 0 || add < int(index)) && (remove < 0 || remove >= int(index));
+    if (onBoard != (item < boardCount)) return false;
+  }
+
+  // objects are only moved while on the board
+  for (int i = 0; i < commands.count(); i++)
+  {
+    const StoredCommand &command = commands.at(i);
+    if (command.type != MoveCommand && command.type != MoveGroupCommand) continue;
+    foreach(quint32 item, command.items)
+    {
+      const int add = added.at(item);
+      const int remove = removed.at(item);
+      if ((add >= 0 && i < add) || (remove >= 0 && i > remove)) return false;
+    }
+  }
+  return true;
+}
+
+static quint32 belowNumber(const QHash<const ToDraw *, quint32> &ids, const ToDraw *below)
+{
+  // objects deleted with the commands that owned them are gone from the
+  // table, putting back above them puts back at the bottom
+  if (!below || !ids.contains(below)) return 0;
+  return ids.value(below) + 1;
+}
+
+// The history of the stack, empty if it holds a command we can not write
+QByteArray SavedHistory::save(const QUndoStack *stack, const QList<ToDraw *> &board)
+{
+  QHash<const ToDraw *, quint32> ids;
+  foreach(const ToDraw *item, board)
+    ids.insert(item, ids.count());
+
+  // the objects off the board the commands can put back
+  QList<const ToDraw *> detached;
+  QList<const ToDraw *> referenced;
+  for (int i = 0; i < stack->count(); i++)
+  {
+    const QUndoCommand *command = stack->command(i);
+    if (const ActionAdd *add = dynamic_cast<const ActionAdd *>(command))
+      referenced << add->m_item;
+    else if (const ActionRemove *remove = dynamic_cast<const ActionRemove *>(command))
+      referenced << remove->m_item;
+    else if (const ActionMove *move = dynamic_cast<const ActionMove *>(command))
+      referenced << move->m_item;
+    else if (const ActionMoveGroup *group = dynamic_cast<const ActionMoveGroup *>(command))
+      foreach(const ToDraw *item, group->m_items) referenced << item;
+    else
+      return QByteArray();
+  }
+  foreach(const ToDraw *item, referenced)
+  {
+    if (ids.contains(item)) continue;
+    ids.insert(item, ids.count());
+    detached << item;
+  }
+
+  HistoryWriter out;
+  out.writeNumber(FORMAT_VERSION);
+  out.writeNumber(stack->index());
+  out.writeNumber(board.count());
+
+  QHash<QString, quint32> elements;
+  QStringList names;
+  foreach(const ToDraw *item, detached)
+  {
+    const QString name = item->elementId();
+    if (elements.contains(name)) continue;
+    elements.insert(name, names.count());
+    names << name;
+  }
+  out.writeNumber(names.count());
+  foreach(const QString &name, names)
+    out.writeString(name);
+
+  qint64 itemCursor[2] = { 0, 0 };
+  out.writeNumber(detached.count());
+  foreach(const ToDraw *item, detached)
+  {
+    out.writeNumber(elements.value(item->elementId()));
+    out.writePoint(item->pos(), POSITION_UNITS, itemCursor);
+  }
+
+  qint64 cursor[2] = { 0, 0 };
+  out.writeNumber(stack->count());
+  for (int i = 0; i < stack->count(); i++)
+  {
+    const QUndoCommand *command = stack->command(i);
+    if (const ActionAdd *add = dynamic_cast<const ActionAdd *>(command))
+    {
+      out.writeNumber(AddCommand);
+      out.writeNumber(ids.value(add->m_item));
+    }
+    else if (const ActionRemove *remove = dynamic_cast<const ActionRemove *>(command))
+    {
+      out.writeNumber(RemoveCommand);
+      out.writeNumber(ids.value(remove->m_item));
+      out.writeNumber(belowNumber(ids, remove->m_below));
+      out.writePoint(remove->m_oldPos, FRACTION_UNITS, cursor);
+    }
+    else if (const ActionMove *move = dynamic_cast<const ActionMove *>(command))
+    {
+      out.writeNumber(MoveCommand);
+      out.writeNumber(ids.value(move->m_item));
+      out.writeNumber(belowNumber(ids, move->m_below));
+      out.writePoint(move->m_oldPos, FRACTION_UNITS, cursor);
+      out.writePoint(move->m_newPos, FRACTION_UNITS, cursor);
+    }
+    else if (const ActionMoveGroup *group = dynamic_cast<const ActionMoveGroup *>(command))
+    {
+      out.writeNumber(MoveGroupCommand);
+      out.writeNumber(group->m_items.count());
+      for (int j = 0; j < group->m_items.count(); j++)
+      {
+        out.writeNumber(ids.value(group->m_items.at(j)));
+        out.writeNumber(belowNumber(ids, group->m_below.at(j)));
+        out.writePoint(group->m_oldPos.at(j), FRACTION_UNITS, cursor);
+        out.writePoint(group->m_newPos.at(j), FRACTION_UNITS, cursor);
+      }
+    }
+  }
+  return out.data;
+}
+
+// Fill the empty stack with the history, the board showing where it
+// ended. The whole history is read before anything is created, false if
+// it does not fit the board.
+bool SavedHistory::restore(const QByteArray &history, const QList<ToDraw *> &board, ElementCatalog *catalog,
+                           QGraphicsScene *scene, LayerStack *layers, QUndoStack *stack)
+{
+  HistoryReader in(history);
+  if (in.readNumber() != FORMAT_VERSION) return false;
+  const quint32 index = in.readNumber();
+  if (in.readNumber() != quint32(board.count())) return false;
+
+  const quint32 nameCount = in.readNumber();
+  if (!in.canHold(nameCount)) return false;
+  QStringList names;
+  for (quint32 i = 0; i < nameCount && in.ok(); i++)
+    names << in.readString();
+
+  const quint32 detachedCount = in.readNumber();
+  if (!in.canHold(detachedCount)) return false;
+  QVector<int> detachedElements;
+  QVector<QPointF> detachedPos;
+  qint64 itemCursor[2] = { 0, 0 };
+  for (quint32 i = 0; i < detachedCount && in.ok(); i++)
+  {
+    const quint32 element = in.readNumber();
+    if (element >= nameCount) return false;
+    detachedElements << element;
+    detachedPos << in.readPoint(POSITION_UNITS, itemCursor);
+  }
+
+  const quint32 itemCount = board.count() + detachedCount;
+  const quint32 commandCount = in.readNumber();
+  if (!in.canHold(commandCount) || index > commandCount) return false;
+  QVector<StoredCommand> commands;
+  qint64 cursor[2] = { 0, 0 };
+  for (quint32 i = 0; i < commandCount && in.ok(); i++)
+  {
+    StoredCommand command;
+    command.type = in.readNumber();
+    quint32 count = 1;
+    if (command.type == MoveGroupCommand)
+    {
+      count = in.readNumber();
+      if (!in.canHold(count)) return false;
+    }
+    else if (command.type < AddCommand || command.type > MoveGroupCommand)
+    {
+      return false;
+    }
+
+    for (quint32 j = 0; j < count && in.ok(); j++)
+    {
+      command.items << in.readNumber();
+      if (command.items.last() >= itemCount) return false;
+      if (command.type == AddCommand) continue;
+
+      command.below << in.readNumber();
+      if (command.below.last() > itemCount) return false;
+      command.oldPos << in.readPoint(FRACTION_UNITS, cursor);
+      if (command.type != RemoveCommand)
+        command.newPos << in.readPoint(FRACTION_UNITS, cursor);
+    }
+    commands << command;
+  }
+  if (!in.ok() || !in.atEnd()) return false;
+  if (!consistent(commands, index, board.count(), itemCount)) return false;
+
+  QVector<int> detachedIds;
+  for (quint32 i = 0; i < detachedCount; i++)
+  {
+    detachedIds << catalog->intern(names.at(detachedElements.at(i)));
+    if (detachedIds.last() < 0) return false;
+  }
+
+  QVector<ToDraw *> items = board.toVector();
+  for (quint32 i = 0; i < detachedCount; i++)
+  {
+    ToDraw *item = new ToDraw(catalog->handle(detachedIds.at(i)));
+    item->setPos(detachedPos.at(i));
+    items << item;
+  }
+
+  Action::setRestoring(true);
+  foreach(const StoredCommand &command, commands)
+  {
+    switch (command.type)
+    {
+      case AddCommand:
+        stack->push(new ActionAdd(items.at(command.items.first()), scene, layers));
+        break;
+
+      case RemoveCommand:
+      {
+        ActionRemove *remove = new ActionRemove(scene, layers);
+        remove->m_item = items.at(command.items.first());
+        remove->m_below = command.below.first() ? items.at(command.below.first() - 1) : 0;
+        remove->m_oldPos = command.oldPos.first();
+        stack->push(remove);
+        break;
+      }
+
+      case MoveCommand:
+      {
+        ActionMove *move = new ActionMove(scene, layers);
+        move->m_item = items.at(command.items.first());
+        move->m_below = command.below.first() ? items.at(command.below.first() - 1) : 0;
+        move->m_oldPos = command.oldPos.first();
+        move->m_newPos = command.newPos.first();
+        stack->push(move);
+        break;
+      }
+
+      case MoveGroupCommand:
+      {
+        ActionMoveGroup *group = new ActionMoveGroup(scene, layers);
+        for (int j = 0; j < command.items.count(); j++)
+        {
+          group->m_items << items.at(command.items.at(j));
+          group->m_below << (command.below.at(j) ? items.at(command.below.at(j) - 1) : 0);
+          group->m_oldPos << command.oldPos.at(j);
+          group->m_newPos << command.newPos.at(j);
+        }
+        stack->push(group);
+        break;
+      }
+    }
+  }
+  stack->setIndex(index);
+  Action::setRestoring(false);
+  return true;
+}
+
+// Where the history was when saved and how many commands it has, without
+// checking it
+bool SavedHistory::position(const QByteArray &history, quint32 *index, quint32 *count)
+{
+  HistoryReader in(history);
+  if (in.readNumber() != FORMAT_VERSION) return false;
+  *index = in.readNumber();
+  in.readNumber();
+
+  const quint32 nameCount = in.readNumber();
+  for (quint32 i = 0; i < nameCount && in.ok(); i++)
+    in.readString();
+
+  const quint32 detachedCount = in.readNumber();
+  qint64 itemCursor[2] = { 0, 0 };
+  for (quint32 i = 0; i < detachedCount && in.ok(); i++)
+  {
+    in.readNumber();
+    in.readPoint(POSITION_UNITS, itemCursor);
+  }
+
+  *count = in.readNumber();
+  return in.ok() && *index <= *count;
+}
@@ -0,0 +1,42 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Undo history kept in saved files */
+
+#ifndef _SAVEDHISTORY_H_
+#define _SAVEDHISTORY_H_
+
+#include <QByteArray>
+#include <QList>
+
+class QGraphicsScene;
+class QUndoStack;
+
+class ElementCatalog;
+class LayerStack;
+class ToDraw;
+
+// The commands of an undo stack, done and undone, packed for a saved file.
+//
+// Commands refer to objects by number: first the objects on the board, in
+// the order the file lists them, then the objects only kept for undo and
+// redo, written with their element and position. Element names are
+// written once. Positions are fixed point and written as the difference
+// to the position written before, as variable length integers; the
+// stacking order changes as the object each one was put above.
+class SavedHistory
+{
+  public:
+    static QByteArray save(const QUndoStack *stack, const QList<ToDraw *> &board);
+    static bool restore(const QByteArray &history, const QList<ToDraw *> &board, ElementCatalog *catalog,
+                        QGraphicsScene *scene, LayerStack *layers, QUndoStack *stack);
+    static bool position(const QByteArray &history, quint32 *index, quint32 *count);
+};
+
+#endif
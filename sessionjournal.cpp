@@ -0,0 +1,319 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Crash recovery journal of the current playground */
+
+#include "sessionjournal.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QLockFile>
+#include <QMap>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+
+#include "playground.h"
+#include "todraw.h"
+
+static const char *snapshotMagic = "KTuberlingSnapshotV1";
+static const char *journalMagic = "KTuberlingJournalV1";
+
+static const int FLUSH_DELAY = 1000;		// ms
+static const int FLUSH_BATCH = 32;		// records
+static const int COMPACT_AFTER = 512;		// records
+
+static QString journalDir()
+{
+  return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+}
+
+static QString baseName(int view)
+{
+  if (view == 0) return QStringLiteral("session");
+  return QStringLiteral("session-%1").arg(view);
+}
+
+static QString lockFileName(int view)
+{
+  return journalDir() + QLatin1Char('/') + baseName(view) + QLatin1String(".lock");
+}
+
+bool SessionJournal::s_enabled = true;
+
+SessionJournal::SessionJournal(PlayGround *playGround, int view)
+ : QObject(playGround), m_playGround(playGround), m_lock(0), m_nextId(0), m_generation(0),
+   m_pendingRecords(0), m_recordsSinceSnapshot(0), m_snapshotNeeded(true), m_discarded(!s_enabled)
+{
+  const QString dir = journalDir();
+  if (!m_discarded)
+  {
+    QDir().mkpath(dir);
+    // only the owner going away makes the lock stale
+    m_lock = new QLockFile(lockFileName(view));
+    m_lock->setStaleLockTime(0);
+    m_discarded = !m_lock->tryLock(0);
+  }
+  m_snapshotFileName = dir + QLatin1Char('/') + baseName(view) + QLatin1String(".snapshot");
+  m_journalFile.setFileName(dir + QLatin1Char('/') + baseName(view) + QLatin1String(".journal"));
+
+  m_flushTimer = new QTimer(this);
+  m_flushTimer->setSingleShot(true);
+  m_flushTimer->setInterval(FLUSH_DELAY);
+  connect(m_flushTimer, &QTimer::timeout, this, &SessionJournal::flush);
+
+  // A clean exit has nothing to recover
+  connect(qApp, &QCoreApplication::aboutToQuit, this, &SessionJournal::discard);
+}
+
+SessionJournal::~SessionJournal()
+{
+  delete m_lock;
+}
+
+// The views besides the first one a crashed session left a snapshot for
+QList<int> SessionJournal::recoverableViews()
+{
+  QList<int> views;
+  if (!s_enabled) return views;
+
+  const QStringList snapshots = QDir(journalDir()).entryList(QStringList() << QStringLiteral("session-*.snapshot"), QDir::Files);
+  foreach(const QString &snapshot, snapshots)
+  {
+    bool ok;
+    const int view = snapshot.mid(8, snapshot.length() - 17).toInt(&ok);
+    if (!ok || view <= 0) continue;
+
+    // still in use by another instance
+    QLockFile lock(lockFileName(view));
+    lock.setStaleLockTime(0);
+    if (lock.tryLock(0)) views << view;
+  }
+  qSort(views);
+  return views;
+}
+
+void SessionJournal::recordAdd(const ToDraw *item)
+{
+  const quint32 id = m_nextId++;
+  m_ids.insert(item, id);
+
+  QByteArray record;
+  QDataStream out(&record, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_4_5);
+  out << quint8(AddOperation) << id;
+  item->save(out);
+  appendRecord(record);
+}
+
+void SessionJournal::recordMove(const ToDraw *item)
+{
+  if (!m_ids.contains(item))
+  {
+    requestSnapshot();
+    return;
+  }
+
+  QByteArray record;
+  QDataStream out(&record, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_4_5);
+  out << quint8(MoveOperation) << m_ids.value(item) << item->pos() << item->zValue();
+  appendRecord(record);
+}
+
+void SessionJournal::recordRemove(const ToDraw *item)
+{
+  if (!m_ids.contains(item))
+  {
+    requestSnapshot();
+    return;
+  }
+
+  QByteArray record;
+  QDataStream out(&record, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_4_5);
+  out << quint8(RemoveOperation) << m_ids.take(item);
+  appendRecord(record);
+}
+
+void SessionJournal::appendRecord(const QByteArray &record)
+{
+  if (m_discarded) return;
+
+  m_pending += record;
+  m_pendingRecords++;
+  m_recordsSinceSnapshot++;
+
+  if (m_pendingRecords >= FLUSH_BATCH) flush();
+  else if (!m_flushTimer->isActive()) m_flushTimer->start();
+}
+
+void SessionJournal::requestSnapshot()
+{
+  if (m_discarded) return;
+
+  m_snapshotNeeded = true;
+  if (!m_flushTimer->isActive()) m_flushTimer->start();
+}
+
+void SessionJournal::flush()
+{
+  m_flushTimer->stop();
+  if (m_discarded) return;
+
+  if (m_snapshotNeeded || m_recordsSinceSnapshot >= COMPACT_AFTER)
+  {
+    writeSnapshot();
+    return;
+  }
+
+  if (m_pending.isEmpty()) return;
+
+  m_journalFile.write(m_pending);
+  m_journalFile.flush();
+  m_pending.clear();
+  m_pendingRecords = 0;
+}
+
+// Write the whole board and start a new, empty, journal on top of it
+void SessionJournal::writeSnapshot()
+{
+  const QString board = m_playGround->currentGameboard();
+  if (board.isEmpty()) return;
+
+  const QList<ToDraw *> items = m_playGround->stickers();
+
+  m_ids.clear();
+  m_nextId = 0;
+  m_generation++;
+
+  QSaveFile snapshot(m_snapshotFileName);
+  if (!snapshot.open(QIODevice::WriteOnly)) return;
+
+  QDataStream out(&snapshot);
+  out.setVersion(QDataStream::Qt_4_5);
+  out << QString::fromLatin1(snapshotMagic) << m_generation << board << quint32(items.count());
+  foreach (const ToDraw *item, items)
+  {
+    const quint32 id = m_nextId++;
+    m_ids.insert(item, id);
+    out << id;
+    item->save(out);
+  }
+  if (!snapshot.commit()) return;
+
+  // The snapshot is safe on disk, now the old journal can go.
+  // If we crash in between, the generation mismatch makes the old journal be ignored.
+  m_journalFile.close();
+  if (m_journalFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    QDataStream header(&m_journalFile);
+    header.setVersion(QDataStream::Qt_4_5);
+    header << QString::fromLatin1(journalMagic) << m_generation;
+    m_journalFile.flush();
+  }
+
+  m_pending.clear();
+  m_pendingRecords = 0;
+  m_recordsSinceSnapshot = 0;
+  m_snapshotNeeded = false;
+}
+
+// Tools running their own instance must not touch the journals of the
+// instance the user plays in
+void SessionJournal::setEnabled(bool enabled)
+{
+  s_enabled = enabled;
+}
+
+void SessionJournal::discard()
+{
+  if (m_discarded) return;
+
+  m_discarded = true;
+  m_flushTimer->stop();
+  m_journalFile.close();
+  QFile::remove(m_journalFile.fileName());
+  QFile::remove(m_snapshotFileName);
+}
+
+// Read back the board a crashed session left behind
+bool SessionJournal::recover(QString &board, QList<Item> &items)
+{
+  if (m_discarded) return false;
+
+  QFile snapshot(m_snapshotFileName);
+  if (!snapshot.open(QIODevice::ReadOnly)) return false;
+
+  QDataStream in(&snapshot);
+  in.setVersion(QDataStream::Qt_4_5);
+
+  QString magic;
+  quint32 generation, count;
+  in >> magic;
+  if (magic != QLatin1String(snapshotMagic)) return false;
+  in >> generation >> board >> count;
+
+  QMap<quint32, Item> state;
+  for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+  {
+    quint32 id;
+    Item item;
+    in >> id >> item.pos >> item.element >> item.zValue;
+    state.insert(id, item);
+  }
+  if (in.status() != QDataStream::Ok) return false;
+
+  QFile journal(m_journalFile.fileName());
+  if (journal.open(QIODevice::ReadOnly))
+  {
+    QDataStream records(&journal);
+    records.setVersion(QDataStream::Qt_4_5);
+
+    quint32 journalGeneration;
+    records >> magic >> journalGeneration;
+    if (magic == QLatin1String(journalMagic) && journalGeneration == generation)
+    {
+      while (!records.atEnd())
+      {
+        quint8 operation;
+        quint32 id;
+        Item item;
+        records >> operation >> id;
+        if (operation == AddOperation)
+          records >> item.pos >> item.element >> item.zValue;
+        else if (operation == MoveOperation)
+          records >> item.pos >> item.zValue;
+
+        // a record cut short by the crash, everything before it is good
+        if (records.status() != QDataStream::Ok) break;
+
+        if (operation == AddOperation)
+        {
+          state.insert(id, item);
+        }
+        else if (operation == MoveOperation && state.contains(id))
+        {
+          Item &moved = state[id];
+          moved.pos = item.pos;
+          moved.zValue = item.zValue;
+        }
+        else if (operation == RemoveOperation)
+        {
+          state.remove(id);
+        }
+      }
+    }
+  }
+
+  items = state.values();
+  m_generation = generation;
+  return true;
+}
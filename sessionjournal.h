@@ -0,0 +1,91 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Crash recovery journal of the current playground */
+
+#ifndef _SESSIONJOURNAL_H_
+#define _SESSIONJOURNAL_H_
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QObject>
+#include <QPointF>
+
+class QLockFile;
+class QTimer;
+
+class PlayGround;
+class ToDraw;
+
+// Appends every add, move and remove done on the playground to a journal
+// file. Every now and then the journal is compacted into a snapshot of the
+// whole board. If we crash, the snapshot plus the journal give back the board.
+//
+// Every view has a journal of its own, numbered like the view. The first
+// view keeps the file names older versions used. A journal is locked
+// while in use; one locked by another running instance is neither
+// written nor recovered.
+class SessionJournal : public QObject
+{
+  Q_OBJECT
+
+  public:
+    class Item
+    {
+      public:
+        QPointF pos;
+        QString element;
+        qreal zValue;
+    };
+
+    SessionJournal(PlayGround *playGround, int view);
+    ~SessionJournal();
+
+    static QList<int> recoverableViews();
+    static void setEnabled(bool enabled);
+
+    void recordAdd(const ToDraw *item);
+    void recordMove(const ToDraw *item);
+    void recordRemove(const ToDraw *item);
+
+    bool recover(QString &board, QList<Item> &items);
+
+  public Q_SLOTS:
+    // the board changed in a way we do not journal, take a full snapshot
+    void requestSnapshot();
+    void flush();
+    void discard();
+
+  private:
+    enum Operation { AddOperation = 1, MoveOperation, RemoveOperation };
+
+    void appendRecord(const QByteArray &record);
+    void writeSnapshot();
+
+    PlayGround *m_playGround;
+    QString m_snapshotFileName;
+    QLockFile *m_lock;
+    QFile m_journalFile;
+
+    QHash<const ToDraw *, quint32> m_ids;	// journal id of the items on the board
+    quint32 m_nextId;
+    quint32 m_generation;			// the snapshot the journal applies to
+
+    QByteArray m_pending;			// records not written yet
+    int m_pendingRecords;
+    int m_recordsSinceSnapshot;
+    bool m_snapshotNeeded;
+    bool m_discarded;				// or never ours
+    QTimer *m_flushTimer;
+
+    static bool s_enabled;
+};
+
+#endif
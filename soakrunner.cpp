@@ -0,0 +1,247 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Long randomized runs looking for memory and latency drift */
+
+#include "soakrunner.h"
+
+#include <KActionCollection>
+#include <KStandardAction>
+
+#include <QAction>
+#include <QApplication>
+#include <QBuffer>
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+
+#include <unistd.h>
+
+#include "elementcatalog.h"
+#include "playground.h"
+#include "todraw.h"
+#include "toplevel.h"
+
+static const qint64 SAMPLE_INTERVAL = 10000;	// ms
+
+// How often each operation is run, relative to the others
+static const int operationWeights[] = { 30, 25, 15, 10, 8, 4, 3, 5 };
+static const char *operationNames[] = { "pick", "drag", "remove", "undo", "redo", "board", "language", "save and load" };
+
+static qint64 residentBytes()
+{
+  QFile statm(QStringLiteral("/proc/self/statm"));
+  if (!statm.open(QIODevice::ReadOnly)) return -1;
+
+  const QList<QByteArray> fields = statm.readAll().split(' ');
+  if (fields.count() < 2) return -1;
+  return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+}
+
+SoakRunner::SoakRunner(TopLevel *topLevel, quint32 seed, int minutes, const Limits &limits)
+ : QObject(topLevel), m_topLevel(topLevel), m_random(seed), m_duration(qint64(minutes) * 60000), m_limits(limits),
+   m_intervalOperations(0), m_intervalLatency(0)
+{
+}
+
+void SoakRunner::start()
+{
+  QTextStream out(stdout);
+  out << "elapsed s" << '\t' << "rss KiB" << '\t' << "items" << '\t' << "undo" << '\t' << "mean ms" << '\n';
+  out.flush();
+
+  m_clock.start();
+  QTimer::singleShot(0, this, SLOT(runNext()));
+}
+
+// One operation per turn of the event loop, so the background renderings
+// and the timers of the application keep running as they would
+void SoakRunner::runNext()
+{
+  if (m_clock.elapsed() >= qint64(m_samples.count() + 1) * SAMPLE_INTERVAL)
+    takeSample();
+
+  if (m_clock.elapsed() >= m_duration)
+  {
+    if (m_intervalOperations) takeSample();
+    qApp->exit(report() ? 0 : 1);
+    return;
+  }
+
+  const Operation operation = randomOperation();
+  QElapsedTimer timer;
+  timer.start();
+  run(operation);
+  // paint synchronously so the rendering cost of the operation is measured too
+  m_topLevel->currentPlayGround()->viewport()->repaint();
+  const qint64 nsecs = timer.nsecsElapsed();
+
+  m_phases[QLatin1String(operationNames[operation])].add(nsecs);
+  m_intervalOperations++;
+  m_intervalLatency += nsecs;
+
+  QTimer::singleShot(0, this, SLOT(runNext()));
+}
+
+SoakRunner::Operation SoakRunner::randomOperation()
+{
+  int total = 0;
+  for (int i = 0; i < OperationCount; i++) total += operationWeights[i];
+
+  int pick = randomInt(total);
+  int operation = 0;
+  while (pick >= operationWeights[operation])
+  {
+    pick -= operationWeights[operation];
+    operation++;
+  }
+  return Operation(operation);
+}
+
+int SoakRunner::randomInt(int count)
+{
+  return std::uniform_int_distribution<int>(0, count - 1)(m_random);
+}
+
+QPointF SoakRunner::randomPointIn(const QRectF &rect)
+{
+  std::uniform_real_distribution<qreal> x(rect.left(), rect.right());
+  std::uniform_real_distribution<qreal> y(rect.top(), rect.bottom());
+  return QPointF(x(m_random), y(m_random));
+}
+
+void SoakRunner::run(Operation operation)
+{
+  PlayGround *playGround = m_topLevel->currentPlayGround();
+  ElementCatalog *catalog = playGround->catalog();
+  if (!catalog || catalog->objectCount() == 0) return;
+
+  const QList<ToDraw *> stickers = playGround->stickers();
+  // the warehouse is outside of the background, dropping there removes
+  const QPointF warehouse = catalog->bounds(catalog->objectId(randomInt(catalog->objectCount()))).center();
+
+  switch (operation)
+  {
+    case PickOperation:
+      moveItem(playGround, warehouse, randomPointIn(catalog->backgroundRect()));
+      break;
+
+    case DragOperation:
+    case RemoveOperation:
+      if (!stickers.isEmpty())
+      {
+        const ToDraw *item = stickers.at(randomInt(stickers.count()));
+        const QPointF from = item->mapToScene(item->boundingRect().center());
+        moveItem(playGround, from, operation == DragOperation ? randomPointIn(catalog->backgroundRect()) : warehouse);
+      }
+      break;
+
+    case UndoOperation:
+    case RedoOperation:
+    {
+      QAction *action = m_topLevel->actionCollection()->action(KStandardAction::name(operation == UndoOperation ? KStandardAction::Undo : KStandardAction::Redo));
+      if (action && action->isEnabled()) action->trigger();
+      break;
+    }
+
+    case BoardOperation:
+    {
+      const QStringList boards = m_topLevel->gameboards();
+      if (!boards.isEmpty()) m_topLevel->changeGameboard(boards.at(randomInt(boards.count())));
+      break;
+    }
+
+    case LanguageOperation:
+    {
+      const QStringList languages = m_topLevel->soundFiles();
+      if (!languages.isEmpty()) m_topLevel->changeLanguage(languages.at(randomInt(languages.count())));
+      break;
+    }
+
+    case SaveLoadOperation:
+    {
+      QByteArray data;
+      QBuffer buffer(&data);
+      buffer.open(QIODevice::WriteOnly);
+      playGround->saveTo(&buffer, true);
+      buffer.close();
+      buffer.open(QIODevice::ReadOnly);
+      playGround->loadFrom(&buffer);
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+// Pick up what is at from with a click and put it down at to with another
+void SoakRunner::moveItem(PlayGround *playGround, const QPointF &from, const QPointF &to)
+{
+  InputReplayer::sendMouse(playGround, QEvent::MouseButtonPress, from, Qt::LeftButton, Qt::LeftButton);
+  InputReplayer::sendMouse(playGround, QEvent::MouseButtonRelease, from, Qt::LeftButton, Qt::NoButton);
+  InputReplayer::sendMouse(playGround, QEvent::MouseMove, (from + to) / 2, Qt::NoButton, Qt::NoButton);
+  InputReplayer::sendMouse(playGround, QEvent::MouseMove, to, Qt::NoButton, Qt::NoButton);
+  InputReplayer::sendMouse(playGround, QEvent::MouseButtonPress, to, Qt::LeftButton, Qt::LeftButton);
+  InputReplayer::sendMouse(playGround, QEvent::MouseButtonRelease, to, Qt::LeftButton, Qt::NoButton);
+}
+
+void SoakRunner::takeSample()
+{
+  PlayGround *playGround = m_topLevel->currentPlayGround();
+
+  Sample sample;
+  sample.elapsed = m_clock.elapsed();
+  sample.rss = residentBytes();
+  sample.items = playGround->stickers().count();
+  sample.undoCount = playGround->undoCount();
+  sample.meanLatency = m_intervalOperations ? m_intervalLatency / m_intervalOperations : 0;
+  m_samples << sample;
+  m_intervalOperations = 0;
+  m_intervalLatency = 0;
+
+  QTextStream out(stdout);
+  out << sample.elapsed / 1000 << '\t' << sample.rss / 1024 << '\t' << sample.items << '\t'
+      << sample.undoCount << '\t' << QString::number(sample.meanLatency / 1000000.0, 'f', 3) << '\n';
+  out.flush();
+}
+
+// Print the timings and compare the last sample to the first one taken
+// once the caches were warm, false if the run failed
+bool SoakRunner::report()
+{
+  QTextStream out(stdout);
+  out << "KTuberling soak run of " << m_clock.elapsed() / 1000 << " s\n";
+  InputReplayer::printPhases(out, m_phases);
+
+  if (m_samples.count() < 3)
+  {
+    out << "Too short to compare samples\n";
+    return true;
+  }
+
+  const Sample &first = m_samples.at(1);
+  const Sample &last = m_samples.last();
+  bool passed = true;
+
+  const qint64 rssGrowth = last.rss - first.rss;
+  out << "Resident memory grew by " << rssGrowth / 1024 << " KiB, the limit is " << m_limits.rssGrowth / 1024 << " KiB\n";
+  if (rssGrowth > m_limits.rssGrowth) passed = false;
+
+  if (first.meanLatency > 0)
+  {
+    const qreal latencyGrowth = qreal(last.meanLatency) / first.meanLatency;
+    out << "Mean latency grew by a factor of " << QString::number(latencyGrowth, 'f', 2) << ", the limit is " << m_limits.latencyGrowth << '\n';
+    if (latencyGrowth > m_limits.latencyGrowth) passed = false;
+  }
+
+  out << (passed ? "PASSED" : "FAILED") << '\n';
+  out.flush();
+  return passed;
+}
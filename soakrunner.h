@@ -0,0 +1,91 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Long randomized runs looking for memory and latency drift */
+
+#ifndef _SOAKRUNNER_H_
+#define _SOAKRUNNER_H_
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QObject>
+#include <QVector>
+
+#include <random>
+
+#include "inputrecorder.h"
+
+class PlayGround;
+class TopLevel;
+
+// Drives the playground with random operations, the same ones for the
+// same seed: picks from the warehouse, drags, drops outside the
+// background, undo and redo, board and language switches, and saving and
+// loading. Every SAMPLE_INTERVAL the resident memory, the number of
+// stickers, the undo stack size and the mean operation latency are
+// printed. The run fails when the memory or the latency grew past the
+// limits; the first interval warms the caches up and is not compared.
+class SoakRunner : public QObject
+{
+  Q_OBJECT
+
+  public:
+    class Limits
+    {
+      public:
+        Limits() : rssGrowth(64 * 1024 * 1024), latencyGrowth(2.0) {}
+
+        qint64 rssGrowth;	// bytes the resident memory may grow by
+        qreal latencyGrowth;	// factor the mean latency may grow by
+    };
+
+    SoakRunner(TopLevel *topLevel, quint32 seed, int minutes, const Limits &limits);
+
+    void start();
+
+  private Q_SLOTS:
+    void runNext();
+
+  private:
+    enum Operation
+    {
+      PickOperation, DragOperation, RemoveOperation, UndoOperation, RedoOperation,
+      BoardOperation, LanguageOperation, SaveLoadOperation, OperationCount
+    };
+
+    class Sample
+    {
+      public:
+        qint64 elapsed;		// ms
+        qint64 rss;		// bytes
+        int items;
+        int undoCount;
+        qint64 meanLatency;	// ns, over the operations since the last sample
+    };
+
+    Operation randomOperation();
+    int randomInt(int count);
+    QPointF randomPointIn(const QRectF &rect);
+    void run(Operation operation);
+    void moveItem(PlayGround *playGround, const QPointF &from, const QPointF &to);
+    void takeSample();
+    bool report();
+
+    TopLevel *m_topLevel;
+    std::mt19937 m_random;
+    qint64 m_duration;				// ms
+    Limits m_limits;
+    QElapsedTimer m_clock;
+    QMap<QString, InputReplayer::PhaseTimes> m_phases;
+    int m_intervalOperations;			// since the last sample
+    qint64 m_intervalLatency;
+    QVector<Sample> m_samples;
+};
+
+#endif
@@ -20,11 +20,11 @@
 #include <phonon/MediaObject>
 
 #include <QDir>
-#include <QDomDocument>
-#include <QFile>
 #include <QStandardPaths>
 
+#include "thememanifest.h"
 #include "toplevel.h"
+#include "tracer.h"
 
 // Constructor
 SoundFactory::SoundFactory(TopLevel *parent)
@@ -47,6 +47,8 @@ void SoundFactory::playSound(const QString &soundRef) const
 
   if (!topLevel->isSoundEnabled()) return;
 
+  TraceScope trace("playSound");
+
   for (sound = 0; sound < sounds; sound++)
 	  if (!namesList[sound].compare(soundRef)) break;
   if (sound == sounds) return;
@@ -75,16 +77,12 @@ void SoundFactory::registerLanguages()
 
   foreach(const QString &soundTheme, list)
   {
-    QFile file(soundTheme);
-    if (file.open(QIODevice::ReadOnly))
+    const SoundThemeManifest *manifest = SoundThemeManifest::get(soundTheme);
+    if (manifest)
     {
-      QDomDocument document;
-      if (document.setContent(&file))
-      {
-        QString code = document.documentElement().attribute(QStringLiteral( "code" ));
-        bool enabled = !(QStandardPaths::locate(QStandardPaths::AppDataLocation, QLatin1String( "sounds/" ) + code + QLatin1Char( '/' ), QStandardPaths::LocateDirectory).isEmpty());
-        topLevel->registerLanguage(code, soundTheme, enabled);
-      }
+      const QString &code = manifest->code;
+      bool enabled = !(QStandardPaths::locate(QStandardPaths::AppDataLocation, QLatin1String( "sounds/" ) + code + QLatin1Char( '/' ), QStandardPaths::LocateDirectory).isEmpty());
+      topLevel->registerLanguage(code, soundTheme, enabled);
     }
   }
 }
@@ -92,36 +90,20 @@ void SoundFactory::registerLanguages()
 // Load the sounds of one given language
 bool SoundFactory::loadLanguage(const QString &selectedLanguageFile)
 {
-  QDomNodeList languagesList,
-               soundNamesList;
-  QDomElement languageElement,
-              soundNameElement;
-  QDomAttr nameAttribute, fileAttribute;
-
-  QFile file(selectedLanguageFile);
-  if (!file.open(QIODevice::ReadOnly)) return false;
-
-  QDomDocument document;
-  if (!document.setContent(&file)) return false;
+  // parsed only once per session
+  const SoundThemeManifest *manifest = SoundThemeManifest::get(selectedLanguageFile);
+  if (!manifest) return false;
 
-  languageElement = document.documentElement();
-
-  soundNamesList = languageElement.elementsByTagName(QStringLiteral( "sound" ));
-  sounds = soundNamesList.count();
-  if (sounds < 1)
+  if (manifest->sounds.count() < 1)
     return false;
 
-
+  sounds = manifest->sounds.count();
   namesList.clear();
   filesList.clear();
-  for (int sound = 0; sound < sounds; sound++)
+  foreach(const SoundThemeManifest::Sound &sound, manifest->sounds)
   {
-    soundNameElement = (const QDomElement &) soundNamesList.item(sound).toElement();
-
-    nameAttribute = soundNameElement.attributeNode(QStringLiteral( "name" ));
-    namesList << nameAttribute.value();
-    fileAttribute = soundNameElement.attributeNode(QStringLiteral( "file" ));
-    filesList << fileAttribute.value();
+    namesList << sound.name;
+    filesList << sound.file;
   }
 
   currentSndFile = selectedLanguageFile;
@@ -0,0 +1,148 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Renderings shared by every running ktuberling */
+
+#include "spritecache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+#include "tracer.h"
+
+static const quint32 SPRITE_MAGIC = 0x5053544b;	// "KTSP"
+static const quint32 SPRITE_VERSION = 2;
+static const quint32 MAX_SPRITE_SIDE = 0x7fff;	// pixels
+
+namespace
+{
+  // Followed by the pixels, 32 bytes keep their lines aligned
+  class Header
+  {
+    public:
+      quint32 magic;
+      quint32 version;
+      quint32 width;
+      quint32 height;
+      quint32 bytesPerLine;
+      quint32 format;
+      quint32 reserved[2];
+  };
+}
+
+// The shared directory, or the user's own cache if there is none we may
+// write to
+static QString findCacheDirectory()
+{
+#ifdef Q_OS_UNIX
+  const QString system = QStringLiteral( "/var/cache/ktuberling" );
+  if (QFileInfo(system).isDir() && QFileInfo(system).isWritable()) return system;
+
+  const QString shared = QStringLiteral( "/var/tmp/ktuberling-sprites" );
+  // like /tmp: every user may add files, only their owner may remove them
+  if (!QFileInfo::exists(shared) && QDir().mkdir(shared))
+    ::chmod(QFile::encodeName(shared).constData(), 01777);
+  if (QFileInfo(shared).isDir() && QFileInfo(shared).isWritable()) return shared;
+#endif
+
+  const QString own = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String( "/ktuberling/sprites" );
+  if (QDir().mkpath(own)) return own;
+  return QString();
+}
+
+static QString cacheDirectory()
+{
+  static const QString directory = findCacheDirectory();
+  return directory;
+}
+
+static QString spriteFile(const QString &directory, const QString &key)
+{
+  const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+  return directory + QStringLiteral( "/v%1-%2.sprite" ).arg(SPRITE_VERSION).arg(QString::fromLatin1(hash));
+}
+
+// Unmaps the pixels once no copy of the image uses them any more
+static void unmapSprite(void *file)
+{
+  delete static_cast<QFile *>(file);
+}
+
+// The image is read only, its pixels are those of the mapped file
+bool SpriteCache::find(const QString &key, QImage *image)
+{
+  TraceScope trace("spriteCacheFind");
+  const QString directory = cacheDirectory();
+  if (directory.isEmpty()) return false;
+
+  QFile *file = new QFile(spriteFile(directory, key));
+  if (!file->open(QIODevice::ReadOnly))
+  {
+    delete file;
+    return false;
+  }
+  const qint64 size = file->size();
+  const uchar *data = size >= qint64(sizeof(Header)) ? file->map(0, size) : 0;
+  // the mapping stays until the file object is deleted
+  file->close();
+
+  const Header *header = reinterpret_cast<const Header *>(data);
+  if (!header || header->magic != SPRITE_MAGIC || header->version != SPRITE_VERSION ||
+      header->format != quint32(QImage::Format_ARGB32_Premultiplied) ||
+      header->width == 0 || header->width > MAX_SPRITE_SIDE ||
+      header->height == 0 || header->height > MAX_SPRITE_SIDE ||
+      header->bytesPerLine < header->width * 4 || header->bytesPerLine % 4 != 0 ||
+      qint64(sizeof(Header)) + qint64(header->bytesPerLine) * header->height > size)
+  {
+    delete file;
+    return false;
+  }
+
+  *image = QImage(data + sizeof(Header), header->width, header->height, header->bytesPerLine, QImage::Format_ARGB32_Premultiplied, unmapSprite, file);
+  return true;
+}
+
+// Nothing is written if the rendering is there already or another
+// session is writing it
+void SpriteCache::insert(const QString &key, const QImage &image)
+{
+  const QString directory = cacheDirectory();
+  if (directory.isEmpty() || image.format() != QImage::Format_ARGB32_Premultiplied) return;
+
+  const QString fileName = spriteFile(directory, key);
+  if (QFile::exists(fileName)) return;
+
+  QLockFile lock(fileName + QLatin1String( ".lock" ));
+  if (!lock.tryLock(0) || QFile::exists(fileName)) return;
+
+  QSaveFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly)) return;
+  file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ReadGroup | QFileDevice::ReadOther);
+
+  Header header;
+  header.magic = SPRITE_MAGIC;
+  header.version = SPRITE_VERSION;
+  header.width = image.width();
+  header.height = image.height();
+  header.bytesPerLine = image.bytesPerLine();
+  header.format = QImage::Format_ARGB32_Premultiplied;
+  header.reserved[0] = header.reserved[1] = 0;
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(image.constBits()), qint64(image.bytesPerLine()) * image.height());
+  file.commit();
+}
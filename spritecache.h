@@ -0,0 +1,43 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Renderings shared by every running ktuberling */
+
+#ifndef _SPRITECACHE_H_
+#define _SPRITECACHE_H_
+
+#include <QImage>
+#include <QString>
+
+// When many sessions run on the same machine, for every user of a
+// classroom server, they all render the same playgrounds at the same few
+// sizes. Each rendering is written once, as raw pixels, to a file of a
+// cache directory shared by all users; the other sessions map that file
+// read only and draw straight from it, so they neither render it again
+// nor hold a copy of their own.
+//
+// The directory is /var/cache/ktuberling when the administrator made it
+// writable, else one in /var/tmp that the first session creates for
+// everybody. Files are written to a temporary file and renamed, under a
+// lock, so sessions starting together never see half written ones.
+//
+// Keys name the source file and its modification time, the element and
+// the size. The directory and the files carry a version to bump when the
+// way elements are rendered or stored changes.
+//
+// Only the render threads and the thumbnailer use the cache, and they may
+// use it at the same time.
+class SpriteCache
+{
+  public:
+    static bool find(const QString &key, QImage *image);
+    static void insert(const QString &key, const QImage &image);
+};
+
+#endif
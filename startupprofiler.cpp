@@ -0,0 +1,85 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Startup phase profiler */
+
+#include "startupprofiler.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+
+namespace
+{
+  struct Phase
+  {
+    QString name;
+    int depth;
+    qint64 start;	// nanoseconds since the profiler was enabled
+    qint64 end;
+  };
+
+  QVector<Phase> phases;
+  int depth = 0;
+  bool reported = false;
+  QElapsedTimer clock;
+
+  QString formatMs(qint64 nsecs)
+  {
+    return QString::number(nsecs / 1000000.0, 'f', 2).rightJustified(10) + QLatin1String(" ms");
+  }
+}
+
+bool StartupProfiler::s_enabled = false;
+
+void StartupProfiler::enable()
+{
+  clock.start();
+  s_enabled = true;
+}
+
+int StartupProfiler::beginPhase(const QString &name)
+{
+  Phase phase;
+  phase.name = name;
+  phase.depth = depth++;
+  phase.start = clock.nsecsElapsed();
+  phase.end = -1;
+  phases << phase;
+  return phases.count() - 1;
+}
+
+void StartupProfiler::endPhase(int phase)
+{
+  phases[phase].end = clock.nsecsElapsed();
+  depth--;
+}
+
+void StartupProfiler::firstFrame()
+{
+  if (!s_enabled || reported) return;
+  reported = true;
+
+  const qint64 firstFrameTime = clock.nsecsElapsed();
+
+  QTextStream out(stdout);
+  out << "KTuberling startup profile\n";
+  foreach (const Phase &phase, phases)
+  {
+    const QString name = QString(phase.depth * 2, QLatin1Char(' ')) + phase.name;
+    out << name.leftJustified(50) << formatMs(phase.end - phase.start) << '\n';
+  }
+  out << QStringLiteral("first frame").leftJustified(50) << formatMs(firstFrameTime) << '\n';
+  out.flush();
+
+  // the report is all that was asked for
+  QTimer::singleShot(0, qApp, SLOT(quit()));
+}
@@ -0,0 +1,55 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Startup phase profiler */
+
+#ifndef _STARTUPPROFILER_H_
+#define _STARTUPPROFILER_H_
+
+#include <QString>
+
+// Times the phases run before the first frame is painted.
+// Enabled by --profile-startup, the report is printed on the first
+// frame and the application quits afterwards.
+class StartupProfiler
+{
+  public:
+    static void enable();
+    static inline bool isEnabled() { return s_enabled; }
+
+    static int beginPhase(const QString &name);
+    static void endPhase(int phase);
+
+    static void firstFrame();
+
+  private:
+    static bool s_enabled;
+};
+
+// Times one phase, phases started while this one is running are nested in it
+class StartupPhase
+{
+  public:
+    explicit StartupPhase(const QString &name)
+     : m_phase(StartupProfiler::isEnabled() ? StartupProfiler::beginPhase(name) : -1)
+    {
+    }
+
+    ~StartupPhase()
+    {
+      if (m_phase >= 0) StartupProfiler::endPhase(m_phase);
+    }
+
+  private:
+    Q_DISABLE_COPY(StartupPhase)
+
+    int m_phase;
+};
+
+#endif
@@ -0,0 +1,171 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Cache of decompressed .svgz documents */
+
+#include "svgcache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <zlib.h>
+
+namespace
+{
+  class Entry
+  {
+    public:
+      qint64 size;
+      qint64 modified;
+      qint64 documentSize;		// still known once the document is released
+      QByteArray document;
+  };
+
+  QHash<QString, Entry> documents;
+}
+
+static bool isCompressed(const QByteArray &data)
+{
+  return data.size() >= 2 && uchar(data.at(0)) == 0x1f && uchar(data.at(1)) == 0x8b;
+}
+
+// Not CacheLocation, the thumbnailer runs under another application name
+static QString diskCacheFile(const QString &svgFile)
+{
+  const QByteArray hash = QCryptographicHash::hash(svgFile.toUtf8(), QCryptographicHash::Sha1).toHex();
+  return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String( "/ktuberling/svg/" ) + QString::fromLatin1(hash) + QLatin1String( ".svg" );
+}
+
+// The decompressed document written by an earlier session, if it is still
+// the one of the file
+static bool readDiskCache(const QString &svgFile, Entry &entry)
+{
+  QFile file(diskCacheFile(svgFile));
+  if (!file.open(QIODevice::ReadOnly)) return false;
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_4_5);
+  qint64 size, modified;
+  in >> size >> modified;
+  if (in.status() != QDataStream::Ok || size != entry.size || modified != entry.modified) return false;
+
+  entry.document = file.readAll();
+  return !entry.document.isEmpty();
+}
+
+static void writeDiskCache(const QString &svgFile, const Entry &entry)
+{
+  const QString cacheFile = diskCacheFile(svgFile);
+  QDir().mkpath(QFileInfo(cacheFile).absolutePath());
+
+  QSaveFile file(cacheFile);
+  if (!file.open(QIODevice::WriteOnly)) return;
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_4_5);
+  out << entry.size << entry.modified;
+  out.writeRawData(entry.document.constData(), entry.document.size());
+  file.commit();
+}
+
+// The XML of an .svg or .svgz file, gunzipped at most once
+QByteArray SvgCache::document(const QString &svgFile)
+{
+  const QFileInfo info(svgFile);
+  Entry entry;
+  entry.size = info.size();
+  entry.modified = info.lastModified().toMSecsSinceEpoch();
+
+  QHash<QString, Entry>::const_iterator it = documents.constFind(svgFile);
+  if (it != documents.constEnd() && it->size == entry.size && it->modified == entry.modified && !it->document.isNull())
+    return it->document;
+
+  QFile file(svgFile);
+  if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+
+  // uncompressed documents cost nothing more to read again
+  const QByteArray magic = file.peek(2);
+  if (!isCompressed(magic))
+    return file.readAll();
+
+  if (!readDiskCache(svgFile, entry))
+  {
+    entry.document = uncompress(file.readAll());
+    if (entry.document.isEmpty()) return QByteArray();
+    writeDiskCache(svgFile, entry);
+  }
+
+  entry.documentSize = entry.document.size();
+  documents.insert(svgFile, entry);
+  return entry.document;
+}
+
+// The size of the XML, without gunzipping the file if it was not yet
+qint64 SvgCache::documentSize(const QString &svgFile)
+{
+  QHash<QString, Entry>::const_iterator it = documents.constFind(svgFile);
+  if (it != documents.constEnd()) return it->documentSize;
+  return QFileInfo(svgFile).size();
+}
+
+// Bytes held in memory for the file
+qint64 SvgCache::memoryUsage(const QString &svgFile)
+{
+  return documents.value(svgFile).document.size();
+}
+
+// Drop the decompressed document from memory, it is read from the disk
+// cache when needed again
+void SvgCache::release(const QString &svgFile)
+{
+  QHash<QString, Entry>::iterator it = documents.find(svgFile);
+  if (it != documents.end())
+    it->document = QByteArray();
+}
+
+// Gunzip the data, if it is gzipped
+QByteArray SvgCache::uncompress(const QByteArray &data)
+{
+  if (!isCompressed(data)) return data;
+
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+  stream.avail_in = data.size();
+  if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) return QByteArray();
+
+  QByteArray result;
+  char chunk[16384];
+  int status;
+  do
+  {
+    stream.next_out = reinterpret_cast<Bytef *>(chunk);
+    stream.avail_out = sizeof(chunk);
+    status = inflate(&stream, Z_NO_FLUSH);
+    if (status != Z_OK && status != Z_STREAM_END)
+    {
+      inflateEnd(&stream);
+      return QByteArray();
+    }
+    result.append(chunk, sizeof(chunk) - stream.avail_out);
+  }
+  while (status != Z_STREAM_END);
+  inflateEnd(&stream);
+
+  return result;
+}
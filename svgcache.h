@@ -0,0 +1,33 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Cache of decompressed .svgz documents */
+
+#ifndef _SVGCACHE_H_
+#define _SVGCACHE_H_
+
+#include <QByteArray>
+#include <QString>
+
+// Gunzipping a .svgz board takes longer than parsing it. The decompressed
+// documents are kept in memory until released, and on disk so the next
+// session, or the next use after a release, does not gunzip them either.
+// Entries are keyed by the path, size and modification time of the
+// compressed file.
+class SvgCache
+{
+  public:
+    static QByteArray document(const QString &svgFile);
+    static qint64 documentSize(const QString &svgFile);
+    static qint64 memoryUsage(const QString &svgFile);
+    static void release(const QString &svgFile);
+    static QByteArray uncompress(const QByteArray &data);
+};
+
+#endif
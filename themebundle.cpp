@@ -0,0 +1,155 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Precompiled playground, written by ktuberling-themec */
+
+#include "themebundle.h"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <climits>
+
+static const char *bundleMagic = "KTuberlingBundleV1";
+
+// Whether count records of at least recordSize bytes each can still follow
+// in a file of fileSize bytes, so a corrupt count cannot make us allocate gigabytes
+static bool fitsInBundle(QDataStream &in, quint32 count, qint64 recordSize, qint64 fileSize)
+{
+  if (in.status() != QDataStream::Ok) return false;
+  const qint64 remaining = fileSize - in.device()->pos();
+  return count <= quint32(INT_MAX) && qint64(count) <= remaining / recordSize;
+}
+
+ThemeBundle::ThemeBundle()
+ : m_data(0)
+{
+}
+
+ThemeBundle::~ThemeBundle()
+{
+  // unmapped by the file
+}
+
+// The bundle compiled from a theme, empty if there is none or if the
+// theme was changed after it was compiled
+QString ThemeBundle::fileFor(const QString &themeFile, const QString &svgFile)
+{
+  QString bundleFile = themeFile;
+  if (bundleFile.endsWith(QLatin1String( ".theme" )))
+    bundleFile.chop(6);
+  bundleFile += QLatin1String( ".bundle" );
+
+  const QFileInfo bundle(bundleFile);
+  if (!bundle.exists()) return QString();
+
+  const QDateTime compiled = bundle.lastModified();
+  if (QFileInfo(themeFile).lastModified() > compiled) return QString();
+  if (!svgFile.isEmpty() && QFileInfo(svgFile).lastModified() > compiled) return QString();
+
+  return bundleFile;
+}
+
+bool ThemeBundle::open(const QString &bundleFile)
+{
+  m_file.setFileName(bundleFile);
+  if (!m_file.open(QIODevice::ReadOnly)) return false;
+
+  const qint64 fileSize = m_file.size();
+  m_data = m_file.map(0, fileSize);
+  if (!m_data) return false;
+
+  QByteArray contents = QByteArray::fromRawData(reinterpret_cast<const char *>(m_data), fileSize);
+  QBuffer buffer(&contents);
+  buffer.open(QIODevice::ReadOnly);
+  QDataStream in(&buffer);
+  in.setVersion(QDataStream::Qt_4_5);
+
+  QString magic;
+  in >> magic;
+  if (magic != QLatin1String(bundleMagic)) return false;
+
+  // every element needs at least two empty strings, the scale, the bounds
+  // and the blob index; every blob an offset and a size
+  const qint64 minElementSize = 4 + 4 + 8 + 32 + 4;
+  const qint64 minBlobSize = 4 + 4;
+
+  quint32 count;
+  in >> defaultSize >> backgroundRect >> count;
+  if (!fitsInBundle(in, count, minElementSize, fileSize)) return false;
+  elements.resize(count);
+  for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+  {
+    Element &element = elements[i];
+    double scale;
+    in >> element.name >> element.sound >> scale >> element.bounds >> element.blob;
+    element.scale = scale;
+  }
+
+  in >> count;
+  if (!fitsInBundle(in, count, minBlobSize, fileSize)) return false;
+  m_offsets.resize(count);
+  m_sizes.resize(count);
+  for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+    in >> m_offsets[i] >> m_sizes[i];
+  if (in.status() != QDataStream::Ok) return false;
+
+  // the blobs follow the header
+  const qint64 dataStart = buffer.pos();
+  for (quint32 i = 0; i < count; i++)
+  {
+    m_offsets[i] += dataStart;
+    if (qint64(m_offsets[i]) + m_sizes[i] > fileSize) return false;
+  }
+  for (int i = 0; i < elements.count(); i++)
+  {
+    if (elements.at(i).blob < 0 || elements.at(i).blob >= m_offsets.count()) return false;
+  }
+  return m_offsets.count() >= FirstFragmentBlob;
+}
+
+bool ThemeBundle::write(const QString &bundleFile) const
+{
+  QSaveFile file(bundleFile);
+  if (!file.open(QIODevice::WriteOnly)) return false;
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_4_5);
+
+  out << QString::fromLatin1(bundleMagic) << defaultSize << backgroundRect << quint32(elements.count());
+  foreach(const Element &element, elements)
+    out << element.name << element.sound << double(element.scale) << element.bounds << element.blob;
+
+  out << quint32(blobs.count());
+  quint32 offset = 0;
+  foreach(const QByteArray &blob, blobs)
+  {
+    out << offset << quint32(blob.size());
+    offset += blob.size();
+  }
+  foreach(const QByteArray &blob, blobs)
+    out.writeRawData(blob.constData(), blob.size());
+
+  return out.status() == QDataStream::Ok && file.commit();
+}
+
+// The blob as stored in the mapped file, nothing is copied
+QByteArray ThemeBundle::blob(int index) const
+{
+  if (!m_data) return blobs.value(index);
+  return QByteArray::fromRawData(reinterpret_cast<const char *>(m_data) + m_offsets.at(index), m_sizes.at(index));
+}
+
+QImage ThemeBundle::thumbnail() const
+{
+  return QImage::fromData(blob(ThumbnailBlob), "PNG");
+}
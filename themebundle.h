@@ -0,0 +1,70 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Precompiled playground, written by ktuberling-themec */
+
+#ifndef _THEMEBUNDLE_H_
+#define _THEMEBUNDLE_H_
+
+#include <QByteArray>
+#include <QFile>
+#include <QImage>
+#include <QRectF>
+#include <QSize>
+#include <QVector>
+
+// A .bundle file holds everything loadPlayGround() needs, so the theme
+// file does not have to be interpreted nor the SVG to be decompressed:
+//  - the size of the board and the bounds of every object
+//  - the name, sound and scale of every object
+//  - the thumbnail shown in the playground chooser
+//  - the board as an uncompressed SVG without any editor data
+//  - every object as a small SVG fragment of its own
+//
+// The file is mapped in memory and the SVG documents are only parsed
+// when they are needed.
+class ThemeBundle
+{
+  public:
+    enum { BoardBlob = 0, ThumbnailBlob = 1, FirstFragmentBlob = 2 };
+
+    class Element
+    {
+      public:
+        QString name;
+        QString sound;
+        qreal scale;
+        QRectF bounds;			// unscaled, in playground coordinates
+        qint32 blob;			// BoardBlob if it could not be split out
+    };
+
+    ThemeBundle();
+    ~ThemeBundle();
+
+    static QString fileFor(const QString &themeFile, const QString &svgFile);
+
+    bool open(const QString &bundleFile);
+    bool write(const QString &bundleFile) const;
+
+    QByteArray blob(int index) const;
+    QImage thumbnail() const;
+
+    QSize defaultSize;
+    QRectF backgroundRect;
+    QVector<Element> elements;
+    QVector<QByteArray> blobs;		// only filled when writing
+
+  private:
+    QFile m_file;
+    const uchar *m_data;
+    QVector<quint32> m_offsets;
+    QVector<quint32> m_sizes;
+};
+
+#endif
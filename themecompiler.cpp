@@ -0,0 +1,287 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Build time tool compiling a .theme file into a .bundle file */
+
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QPainter>
+#include <QSvgRenderer>
+#include <QTextStream>
+#include <QVector>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include "svgcache.h"
+#include "themebundle.h"
+#include "thememanifest.h"
+
+static const QString svgNamespace = QStringLiteral( "http://www.w3.org/2000/svg" );
+static const QString xlinkNamespace = QStringLiteral( "http://www.w3.org/1999/xlink" );
+static const QString xmlNamespace = QStringLiteral( "http://www.w3.org/XML/1998/namespace" );
+
+// The size PlayGround::registerPlayGrounds() shows the thumbnails at
+static const QSize thumbnailSize(200, 100);
+
+// Largest side of the images compared to check a fragment
+static const int CHECK_SIZE = 128;
+
+static QTextStream &err()
+{
+  static QTextStream stream(stderr);
+  return stream;
+}
+
+// The XML of an .svg or .svgz file
+static QByteArray readSvg(const QString &svgFile)
+{
+  QFile file(svgFile);
+  if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+  return SvgCache::uncompress(file.readAll());
+}
+
+// Editor data is of no use to the renderer
+static bool isKept(const QXmlStreamReader &reader)
+{
+  return reader.namespaceUri() == svgNamespace && reader.name() != QLatin1String( "metadata" );
+}
+
+static void writeStartElement(QXmlStreamWriter &writer, const QXmlStreamReader &reader)
+{
+  writer.writeStartElement(svgNamespace, reader.name().toString());
+  foreach(const QXmlStreamAttribute &attribute, reader.attributes())
+  {
+    const QStringRef ns = attribute.namespaceUri();
+    if (ns.isEmpty() || ns == xlinkNamespace || ns == xmlNamespace)
+      writer.writeAttribute(attribute);
+  }
+}
+
+// Copy the svg document. If element is not empty only the definitions
+// and that element are kept, with the transformation of its parents.
+static QByteArray strippedSvg(const QByteArray &svg, const QString &element, const QMatrix &matrix)
+{
+  QByteArray result;
+  QXmlStreamReader reader(svg);
+  QXmlStreamWriter writer(&result);
+  writer.writeStartDocument();
+  writer.writeDefaultNamespace(svgNamespace);
+  writer.writeNamespace(xlinkNamespace, QStringLiteral( "xlink" ));
+
+  int depth = 0;		// in the document
+  int skipDepth = 0;		// inside an element we do not copy
+  int copyDepth = 0;		// inside an element we copy when splitting
+  bool wrapped = false;
+  QVector<bool> written;	// whether the open elements were written
+  while (!reader.atEnd())
+  {
+    switch (reader.readNext())
+    {
+      case QXmlStreamReader::StartElement:
+        depth++;
+        if (skipDepth || !isKept(reader))
+        {
+          skipDepth++;
+        }
+        else if (depth == 1 || element.isEmpty() || copyDepth)
+        {
+          writeStartElement(writer, reader);
+          written << true;
+          if (copyDepth) copyDepth++;
+        }
+        else if (reader.name() == QLatin1String( "defs" ) || reader.name() == QLatin1String( "style" ))
+        {
+          writeStartElement(writer, reader);
+          written << true;
+          copyDepth = 1;
+        }
+        else if (reader.attributes().value(QStringLiteral( "id" )) == element)
+        {
+          writer.writeStartElement(svgNamespace, QStringLiteral( "g" ));
+          writer.writeAttribute(QStringLiteral( "transform" ), QStringLiteral( "matrix(%1,%2,%3,%4,%5,%6)" )
+                                .arg(matrix.m11(), 0, 'g', 12).arg(matrix.m12(), 0, 'g', 12)
+                                .arg(matrix.m21(), 0, 'g', 12).arg(matrix.m22(), 0, 'g', 12)
+                                .arg(matrix.dx(), 0, 'g', 12).arg(matrix.dy(), 0, 'g', 12));
+          writeStartElement(writer, reader);
+          written << true;
+          copyDepth = 1;
+          wrapped = true;
+        }
+        else
+        {
+          // look for the element inside, without copying this one
+          written << false;
+        }
+        break;
+
+      case QXmlStreamReader::EndElement:
+        depth--;
+        if (skipDepth)
+        {
+          skipDepth--;
+        }
+        else if (written.takeLast())
+        {
+          writer.writeEndElement();
+          if (copyDepth && --copyDepth == 0 && wrapped)
+          {
+            writer.writeEndElement();
+            wrapped = false;
+          }
+        }
+        break;
+
+      case QXmlStreamReader::Characters:
+      case QXmlStreamReader::EntityReference:
+        if (!skipDepth && (element.isEmpty() ? depth > 0 : copyDepth > 0))
+          writer.writeCurrentToken(reader);
+        break;
+
+      default:
+        break;
+    }
+  }
+  writer.writeEndDocument();
+
+  if (reader.hasError()) return QByteArray();
+  return result;
+}
+
+// Render an element small enough to be compared quickly
+static QImage checkImage(QSvgRenderer &renderer, const QString &element, const QRectF &bounds)
+{
+  QSize size = bounds.size().toSize();
+  size.scale(CHECK_SIZE, CHECK_SIZE, Qt::KeepAspectRatio);
+  QImage image(size.expandedTo(QSize(1, 1)), QImage::Format_ARGB32_Premultiplied);
+  image.fill(Qt::transparent);
+  QPainter painter(&image);
+  renderer.render(&painter, element);
+  painter.end();
+  return image;
+}
+
+static bool sameImage(const QImage &a, const QImage &b)
+{
+  if (a.size() != b.size()) return false;
+  for (int y = 0; y < a.height(); y++)
+  {
+    const QRgb *lineA = reinterpret_cast<const QRgb *>(a.constScanLine(y));
+    const QRgb *lineB = reinterpret_cast<const QRgb *>(b.constScanLine(y));
+    for (int x = 0; x < a.width(); x++)
+    {
+      // allow for rounding in the transformation
+      if (qAbs(qRed(lineA[x]) - qRed(lineB[x])) > 8 || qAbs(qGreen(lineA[x]) - qGreen(lineB[x])) > 8 ||
+          qAbs(qBlue(lineA[x]) - qBlue(lineB[x])) > 8 || qAbs(qAlpha(lineA[x]) - qAlpha(lineB[x])) > 8)
+        return false;
+    }
+  }
+  return true;
+}
+
+static bool compile(const QString &themeFile, const QString &bundleFile)
+{
+  const ThemeManifest *manifest = ThemeManifest::get(themeFile);
+  if (!manifest)
+  {
+    err() << "Could not read " << themeFile << endl;
+    return false;
+  }
+
+  const QString svgFile = QFileInfo(themeFile).absolutePath() + QLatin1Char( '/' ) + manifest->gameboard;
+  const QByteArray svg = readSvg(svgFile);
+  QSvgRenderer renderer;
+  if (svg.isEmpty() || !renderer.load(svg))
+  {
+    err() << "Could not read " << svgFile << endl;
+    return false;
+  }
+
+  ThemeBundle bundle;
+  bundle.defaultSize = renderer.defaultSize();
+  bundle.backgroundRect = renderer.boundsOnElement(QStringLiteral( "background" ));
+
+  const QByteArray board = strippedSvg(svg, QString(), QMatrix());
+  QSvgRenderer boardRenderer;
+  if (board.isEmpty() || !boardRenderer.load(board))
+  {
+    err() << "Could not strip " << svgFile << endl;
+    return false;
+  }
+  bundle.blobs << board;
+
+  QImage thumbnail(thumbnailSize, QImage::Format_ARGB32_Premultiplied);
+  thumbnail.fill(Qt::transparent);
+  QPainter painter(&thumbnail);
+  boardRenderer.render(&painter, QStringLiteral( "background" ));
+  painter.end();
+  QByteArray png;
+  QBuffer pngBuffer(&png);
+  pngBuffer.open(QIODevice::WriteOnly);
+  thumbnail.save(&pngBuffer, "PNG");
+  bundle.blobs << png;
+
+  foreach(const ThemeManifest::Object &object, manifest->objects)
+  {
+    if (!renderer.elementExists(object.name))
+    {
+      err() << object.name << " does not exist. Check " << themeFile << endl;
+      continue;
+    }
+
+    ThemeBundle::Element element;
+    element.name = object.name;
+    element.sound = object.sound;
+    element.scale = object.scale;
+    element.bounds = renderer.boundsOnElement(object.name);
+    element.blob = ThemeBundle::BoardBlob;
+
+    // elements using something outside of themselves and the definitions
+    // stay rendered from the board
+    const QByteArray fragment = strippedSvg(svg, object.name, renderer.matrixForElement(object.name));
+    QSvgRenderer fragmentRenderer;
+    if (!fragment.isEmpty() && fragmentRenderer.load(fragment) &&
+        sameImage(checkImage(renderer, object.name, element.bounds), checkImage(fragmentRenderer, object.name, element.bounds)))
+    {
+      element.blob = bundle.blobs.count();
+      bundle.blobs << fragment;
+    }
+    else
+    {
+      err() << object.name << " could not be split out of " << svgFile << endl;
+    }
+
+    bundle.elements << element;
+  }
+
+  if (!bundle.write(bundleFile))
+  {
+    err() << "Could not write " << bundleFile << endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  // rendering the thumbnails needs no display
+  if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  QGuiApplication app(argc, argv);
+
+  const QStringList args = app.arguments();
+  if (args.count() != 3)
+  {
+    err() << "Usage: " << args.value(0) << " <theme-file> <bundle-file>" << endl;
+    return 1;
+  }
+
+  return compile(args.at(1), args.at(2)) ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Contents of the .theme and .soundtheme files */
+
+#include "thememanifest.h"
+
+#include <QFile>
+#include <QHash>
+#include <QXmlStreamReader>
+
+namespace
+{
+  // files that failed to parse are cached too, as null
+  QHash<QString, ThemeManifest *> themeManifests;
+  QHash<QString, SoundThemeManifest *> soundThemeManifests;
+}
+
+static ThemeManifest *parseTheme(const QString &themeFile)
+{
+  QFile file(themeFile);
+  if (!file.open(QIODevice::ReadOnly)) return 0;
+
+  QXmlStreamReader xml(&file);
+  ThemeManifest *manifest = 0;
+  while (!xml.atEnd())
+  {
+    if (xml.readNext() != QXmlStreamReader::StartElement) continue;
+
+    const QXmlStreamAttributes attributes = xml.attributes();
+    if (!manifest)
+    {
+      // the root element, whatever its name
+      manifest = new ThemeManifest;
+      manifest->gameboard = attributes.value(QStringLiteral( "gameboard" )).toString();
+      manifest->desktop = attributes.value(QStringLiteral( "desktop" )).toString();
+      manifest->bgColor = attributes.hasAttribute(QStringLiteral( "bgcolor" )) ? attributes.value(QStringLiteral( "bgcolor" )).toString() : QStringLiteral( "#fff" );
+    }
+    else if (xml.name() == QLatin1String( "object" ))
+    {
+      ThemeManifest::Object object;
+      object.name = attributes.value(QStringLiteral( "name" )).toString();
+      object.sound = attributes.value(QStringLiteral( "sound" )).toString();
+      object.scale = attributes.hasAttribute(QStringLiteral( "scale" )) ? attributes.value(QStringLiteral( "scale" )).toString().toDouble() : 1;
+      manifest->objects << object;
+    }
+  }
+
+  if (xml.hasError())
+  {
+    delete manifest;
+    return 0;
+  }
+  return manifest;
+}
+
+static SoundThemeManifest *parseSoundTheme(const QString &soundThemeFile)
+{
+  QFile file(soundThemeFile);
+  if (!file.open(QIODevice::ReadOnly)) return 0;
+
+  QXmlStreamReader xml(&file);
+  SoundThemeManifest *manifest = 0;
+  while (!xml.atEnd())
+  {
+    if (xml.readNext() != QXmlStreamReader::StartElement) continue;
+
+    const QXmlStreamAttributes attributes = xml.attributes();
+    if (!manifest)
+    {
+      manifest = new SoundThemeManifest;
+      manifest->code = attributes.value(QStringLiteral( "code" )).toString();
+    }
+    else if (xml.name() == QLatin1String( "sound" ))
+    {
+      SoundThemeManifest::Sound sound;
+      sound.name = attributes.value(QStringLiteral( "name" )).toString();
+      sound.file = attributes.value(QStringLiteral( "file" )).toString();
+      manifest->sounds << sound;
+    }
+  }
+
+  if (xml.hasError())
+  {
+    delete manifest;
+    return 0;
+  }
+  return manifest;
+}
+
+// The contents of a .theme file, null if it can not be read
+const ThemeManifest *ThemeManifest::get(const QString &themeFile)
+{
+  QHash<QString, ThemeManifest *>::const_iterator it = themeManifests.constFind(themeFile);
+  if (it != themeManifests.constEnd())
+    return it.value();
+
+  ThemeManifest *manifest = parseTheme(themeFile);
+  themeManifests.insert(themeFile, manifest);
+  return manifest;
+}
+
+// Forget a .theme file that changed, it is parsed again the next time it
+// is asked for. Nobody keeps what get() returns.
+void ThemeManifest::invalidate(const QString &themeFile)
+{
+  delete themeManifests.take(themeFile);
+}
+
+// The contents of a .soundtheme file, null if it can not be read
+const SoundThemeManifest *SoundThemeManifest::get(const QString &soundThemeFile)
+{
+  QHash<QString, SoundThemeManifest *>::const_iterator it = soundThemeManifests.constFind(soundThemeFile);
+  if (it != soundThemeManifests.constEnd())
+    return it.value();
+
+  SoundThemeManifest *manifest = parseSoundTheme(soundThemeFile);
+  soundThemeManifests.insert(soundThemeFile, manifest);
+  return manifest;
+}
@@ -0,0 +1,56 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Contents of the .theme and .soundtheme files */
+
+#ifndef _THEMEMANIFEST_H_
+#define _THEMEMANIFEST_H_
+
+#include <QString>
+#include <QVector>
+
+// A .theme file, parsed once per session or after it is invalidated
+class ThemeManifest
+{
+  public:
+    class Object
+    {
+      public:
+        QString name;
+        QString sound;
+        qreal scale;
+    };
+
+    static const ThemeManifest *get(const QString &themeFile);
+    static void invalidate(const QString &themeFile);
+
+    QString gameboard;		// the SVG file
+    QString desktop;		// the .desktop file with the translated name
+    QString bgColor;
+    QVector<Object> objects;
+};
+
+// A .soundtheme file, parsed once per session
+class SoundThemeManifest
+{
+  public:
+    class Sound
+    {
+      public:
+        QString name;
+        QString file;
+    };
+
+    static const SoundThemeManifest *get(const QString &soundThemeFile);
+
+    QString code;		// language code
+    QVector<Sound> sounds;
+};
+
+#endif
@@ -0,0 +1,288 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Reloads the playgrounds whose files change */
+
+#include "themewatcher.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSharedPointer>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QtAlgorithms>
+#include <QVector>
+#include <QXmlStreamReader>
+
+#include "elementcatalog.h"
+#include "playground.h"
+#include "svgcache.h"
+#include "thememanifest.h"
+#include "toplevel.h"
+
+// Editors write in several steps, wait for them to be done, in ms
+static const int RELOAD_DELAY = 300;
+
+class OpenElement
+{
+  public:
+    QString id;
+    int depth;
+    QSharedPointer<QCryptographicHash> hash;
+    QSet<QString> references;	// ids used in its subtree or by its parents
+};
+
+// The ids an element refers to, through a link or a paint server
+static QSet<QString> referencedIds(const QXmlStreamAttributes &attributes)
+{
+  static const QRegularExpression url(QStringLiteral( "url\\(\\s*['\"]?#([^)'\"\\s]+)" ));
+  QSet<QString> result;
+  foreach(const QXmlStreamAttribute &attribute, attributes)
+  {
+    const QString value = attribute.value().toString();
+    if (attribute.name() == QLatin1String( "href" ) && value.startsWith(QLatin1Char( '#' )))
+      result << value.mid(1);
+    QRegularExpressionMatchIterator it = url.globalMatch(value);
+    while (it.hasNext())
+      result << it.next().captured(1);
+  }
+  return result;
+}
+
+// The hash of the subtree of every element with an id, starting with the
+// start tags of its parents, so a change of the style of a layer counts
+// for everything in it. The elements it refers to, and those they refer
+// to in turn, are dependencies: their hashes are added to its own. The
+// definitions, and what is outside of any element with an id, go under
+// QString(). Whitespace between the elements does not count.
+static QHash<QString, QByteArray> elementDigests(const QByteArray &svg)
+{
+  QHash<QString, QByteArray> subtrees;
+  QHash<QString, QSet<QString> > references;
+  QCryptographicHash rest(QCryptographicHash::Sha1);
+  QVector<OpenElement> open;
+  QByteArray ancestors;			// start tags of the open elements
+  QVector<int> ancestorSizes;
+  QVector<QSet<QString> > ancestorReferences;
+  int depth = 0;
+  int defsDepth = 0;		// of the definitions being read, 0 if none
+
+  QXmlStreamReader reader(svg);
+  while (!reader.atEnd())
+  {
+    QString token;
+    const QXmlStreamReader::TokenType type = reader.readNext();
+    if (type == QXmlStreamReader::StartElement)
+    {
+      depth++;
+      if (!defsDepth && (reader.name() == QLatin1String( "defs" ) || reader.name() == QLatin1String( "style" )))
+        defsDepth = depth;
+
+      token = QLatin1Char( '<' ) + reader.qualifiedName().toString();
+      foreach(const QXmlStreamAttribute &attribute, reader.attributes())
+        token += QLatin1Char( ' ' ) + attribute.qualifiedName().toString() + QLatin1String( "=\"" ) + attribute.value().toString() + QLatin1Char( '"' );
+      token += QLatin1Char( '>' );
+    }
+    else if (type == QXmlStreamReader::EndElement)
+    {
+      token = QLatin1String( "</" ) + reader.qualifiedName().toString() + QLatin1Char( '>' );
+    }
+    else if (type == QXmlStreamReader::Characters && !reader.isWhitespace())
+    {
+      token = reader.text().toString();
+    }
+    else
+    {
+      continue;
+    }
+
+    const QByteArray data = token.toUtf8();
+    foreach(const OpenElement &element, open)
+      element.hash->addData(data);
+    if (open.isEmpty() || defsDepth)
+      rest.addData(data);
+
+    if (type == QXmlStreamReader::StartElement)
+    {
+      QSet<QString> used = referencedIds(reader.attributes());
+      for (int i = 0; i < open.count(); i++)
+        open[i].references += used;
+      if (!ancestorReferences.isEmpty())
+        used += ancestorReferences.last();
+
+      const QString id = reader.attributes().value(QStringLiteral( "id" )).toString();
+      if (!id.isEmpty())
+      {
+        OpenElement element;
+        element.id = id;
+        element.depth = depth;
+        element.hash = QSharedPointer<QCryptographicHash>(new QCryptographicHash(QCryptographicHash::Sha1));
+        element.hash->addData(ancestors);
+        element.hash->addData(data);
+        element.references = used;
+        open << element;
+      }
+      ancestorSizes << ancestors.size();
+      ancestors += data;
+      ancestorReferences << used;
+    }
+    else if (type == QXmlStreamReader::EndElement)
+    {
+      if (!open.isEmpty() && open.last().depth == depth)
+      {
+        subtrees.insert(open.last().id, open.last().hash->result());
+        references.insert(open.last().id, open.last().references);
+        open.removeLast();
+      }
+      ancestors.truncate(ancestorSizes.takeLast());
+      ancestorReferences.removeLast();
+      if (defsDepth == depth) defsDepth = 0;
+      depth--;
+    }
+  }
+
+  QHash<QString, QByteArray> result;
+  QHash<QString, QByteArray>::const_iterator it;
+  for (it = subtrees.constBegin(); it != subtrees.constEnd(); ++it)
+  {
+    // every element it depends on, whatever the depth, once
+    QStringList dependencies = references.value(it.key()).toList();
+    QSet<QString> seen = references.value(it.key());
+    seen << it.key();
+    for (int i = 0; i < dependencies.count(); i++)
+    {
+      foreach(const QString &id, references.value(dependencies.at(i)))
+      {
+        if (seen.contains(id)) continue;
+        seen << id;
+        dependencies << id;
+      }
+    }
+    qSort(dependencies);
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(it.value());
+    foreach(const QString &id, dependencies)
+    {
+      hash.addData(id.toUtf8());
+      hash.addData(subtrees.value(id));
+    }
+    result.insert(it.key(), hash.result());
+  }
+
+  result.insert(QString(), rest.result());
+  return result;
+}
+
+static QString svgFileOf(const ThemeManifest *manifest)
+{
+  return QStandardPaths::locate(QStandardPaths::AppDataLocation, QLatin1String( "pics/" ) + manifest->gameboard);
+}
+
+ThemeWatcher::ThemeWatcher(TopLevel *topLevel)
+ : QObject(topLevel), m_topLevel(topLevel)
+{
+  m_reloadTimer.setSingleShot(true);
+  m_reloadTimer.setInterval(RELOAD_DELAY);
+  connect(&m_reloadTimer, &QTimer::timeout, this, &ThemeWatcher::reloadChanged);
+  connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &ThemeWatcher::fileChanged);
+
+  foreach(const QString &gameboard, m_topLevel->gameboards())
+    watch(gameboard);
+}
+
+// Remember what the playground looks like now and watch its files
+void ThemeWatcher::watch(const QString &gameboard)
+{
+  Board &board = m_boards[gameboard];
+  m_watcher.addPath(gameboard);
+
+  const ThemeManifest *manifest = ThemeManifest::get(gameboard);
+  if (!manifest) return;
+
+  board.svgFile = svgFileOf(manifest);
+  if (board.svgFile.isEmpty()) return;
+  m_watcher.addPath(board.svgFile);
+  board.digests = elementDigests(SvgCache::document(board.svgFile));
+}
+
+void ThemeWatcher::fileChanged(const QString &file)
+{
+  QHash<QString, Board>::const_iterator it;
+  for (it = m_boards.constBegin(); it != m_boards.constEnd(); ++it)
+  {
+    if (it.key() == file || it->svgFile == file)
+      m_changed << it.key();
+  }
+  m_reloadTimer.start();
+}
+
+void ThemeWatcher::reloadChanged()
+{
+  foreach(const QString &gameboard, m_changed)
+    reload(gameboard);
+  m_changed.clear();
+
+  // editors saving to a new file and renaming it over the old one end
+  // the watching of the old one
+  const QStringList watched = m_watcher.files();
+  QHash<QString, Board>::const_iterator it;
+  for (it = m_boards.constBegin(); it != m_boards.constEnd(); ++it)
+  {
+    if (!watched.contains(it.key()) && QFileInfo::exists(it.key()))
+      m_watcher.addPath(it.key());
+    if (!it->svgFile.isEmpty() && !watched.contains(it->svgFile) && QFileInfo::exists(it->svgFile))
+      m_watcher.addPath(it->svgFile);
+  }
+}
+
+// Read the playground again and have the views update what they show of
+// it. Playgrounds not shown yet are read when they are.
+void ThemeWatcher::reload(const QString &gameboard)
+{
+  ThemeManifest::invalidate(gameboard);
+  const ThemeManifest *manifest = ThemeManifest::get(gameboard);
+  if (!manifest)
+  {
+    qWarning() << "Could not read" << gameboard;
+    return;
+  }
+
+  Board &board = m_boards[gameboard];
+  const QString svgFile = svgFileOf(manifest);
+  if (svgFile != board.svgFile && !svgFile.isEmpty())
+    m_watcher.addPath(svgFile);
+  const QHash<QString, QByteArray> digests = elementDigests(SvgCache::document(svgFile));
+
+  ElementCatalog *catalog = ElementCatalog::forGameboard(gameboard);
+  if (catalog->isLoaded())
+  {
+    QSet<QString> changed;
+    const bool restChanged = svgFile != board.svgFile || digests.value(QString()) != board.digests.value(QString());
+    for (int id = 0; id < catalog->count(); id++)
+    {
+      const QString &name = catalog->name(id);
+      if (restChanged || digests.value(name) != board.digests.value(name))
+        changed << name;
+    }
+
+    if (!catalog->reload(gameboard, svgFile, changed))
+    {
+      qWarning() << "Could not reload" << gameboard;
+      return;
+    }
+    foreach(PlayGround *playGround, m_topLevel->playGrounds())
+      playGround->gameboardReloaded(gameboard);
+  }
+
+  board.svgFile = svgFile;
+  board.digests = digests;
+}
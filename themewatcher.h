@@ -0,0 +1,62 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Reloads the playgrounds whose files change */
+
+#ifndef _THEMEWATCHER_H_
+#define _THEMEWATCHER_H_
+
+#include <QByteArray>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+
+class TopLevel;
+
+// For theme authors: watches the .theme and SVG files of every playground
+// and reads a playground again when they change, without a restart.
+//
+// The SVG elements of the objects are compared with what was read before
+// through a hash of their subtree, of the start tags of their parents and
+// of the elements they use, so only the objects that changed are
+// rendered again. A change anywhere else in the document, in the
+// definitions for instance, may show in any object and counts for all.
+class ThemeWatcher : public QObject
+{
+  Q_OBJECT
+
+  public:
+    explicit ThemeWatcher(TopLevel *topLevel);
+
+  private Q_SLOTS:
+    void fileChanged(const QString &file);
+    void reloadChanged();
+
+  private:
+    class Board
+    {
+      public:
+        QString svgFile;
+        QHash<QString, QByteArray> digests;	// by element, the rest under QString()
+    };
+
+    void watch(const QString &gameboard);
+    void reload(const QString &gameboard);
+
+    TopLevel *m_topLevel;
+    QFileSystemWatcher m_watcher;
+    QHash<QString, Board> m_boards;		// by .theme file
+    QSet<QString> m_changed;			// playgrounds waiting to be reloaded
+    QTimer m_reloadTimer;			// lets an editor finish writing
+};
+
+#endif
@@ -12,58 +12,70 @@
 
 #include "todraw.h"
 
+#include <QApplication>
 #include <QDataStream>
 #include <QPainter>
-#include <QSvgRenderer>
 
-static QImage toImage(const QString &element, int width, int height, QSvgRenderer *renderer)
+#include "elementcatalog.h"
+
+ToDraw::ToDraw(quint32 element)
+ : m_element(element), m_beingDragged(false)
 {
-  QImage img(width, height, QImage::Format_ARGB32_Premultiplied);
-  img.fill(Qt::transparent);
-  QPainter p2(&img);
-  // don't need quality here
-  p2.setRenderHints(QPainter::Antialiasing|QPainter::TextAntialiasing|QPainter::SmoothPixmapTransform, false);
-  renderer->render(&p2, element);
-  p2.end();
-  return img;
+  // we need to know about position changes to update the clipped bounding rect
+  setFlag(QGraphicsItem::ItemSendsGeometryChanges);
+  // the playground handles the selection itself, nothing else changes it
+  setFlag(QGraphicsItem::ItemIsSelectable);
 }
 
+// Save an object to a file
+void ToDraw::save(QDataStream &stream) const
+{
+  save(stream, zValue());
+}
 
-ToDraw::ToDraw()
- : m_beingDragged(false)
+// Save an object to a file with another stacking order value
+void ToDraw::save(QDataStream &stream, qreal stackingOrder) const
 {
+  stream << pos();
+  stream << elementId();
+  stream << stackingOrder;
 }
 
-// Load an object from a file
-bool ToDraw::load(QDataStream &stream)
+ElementCatalog *ToDraw::catalog() const
 {
-  // NOTE: read error checking?
-  QPointF pos;
-  QString element;
-  qreal zOrder;
+  return ElementCatalog::fromHandle(m_element);
+}
+
+int ToDraw::elementIndex() const
+{
+  return ElementCatalog::idFromHandle(m_element);
+}
 
-  stream >> pos;
-  stream >> element;
-  stream >> zOrder;
+quint32 ToDraw::element() const
+{
+  return m_element;
+}
 
-  setPos(pos);
-  setElementId(element);
-  setZValue(zOrder);
+void ToDraw::setElement(quint32 element)
+{
+  prepareGeometryChange();
+  m_element = element;
+}
 
-  return true;
+// The catalog read the element again, its size may be another one
+void ToDraw::elementChanged()
+{
+  prepareGeometryChange();
 }
 
-// Save an object to a file
-void ToDraw::save(QDataStream &stream) const
+QString ToDraw::elementId() const
 {
-  stream << pos();
-  stream << elementId();
-  stream << zValue();
+  return catalog()->name(elementIndex());
 }
 
 QRectF ToDraw::unclippedRect() const
 {
-  return QGraphicsSvgItem::boundingRect();
+  return QRectF(QPointF(0, 0), catalog()->scaledSize(elementIndex()));
 }
 
 QRectF ToDraw::clippedRectAt(const QPointF &somePos) const
@@ -71,9 +83,8 @@ QRectF ToDraw::clippedRectAt(const QPointF &somePos) const
   if (m_beingDragged)
     return unclippedRect();
 
-  QRectF backgroundRect = renderer()->boundsOnElement(QStringLiteral( "background" ));
+  QRectF backgroundRect = catalog()->backgroundRect();
   backgroundRect.translate(-somePos);
-  backgroundRect = transform().inverted().map(backgroundRect).boundingRect();
 
   return unclippedRect().intersected(backgroundRect);
 }
@@ -89,24 +100,62 @@ QRectF ToDraw::boundingRect() const
   return clippedRectAt(pos());
 }
 
+void ToDraw::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *widget)
+{
+  const QRectF rect = unclippedRect();
+
+  // not drawing on the view, printing and exporting get the vectors
+  if (!widget)
+  {
+    painter->save();
+    painter->setClipRect(boundingRect());
+    catalog()->renderer(elementIndex())->render(painter, catalog()->name(elementIndex()), rect);
+    painter->restore();
+    return;
+  }
+
+  // draw the cached rendering of the element at the size it has on the device
+  const QSize deviceSize = painter->worldTransform().mapRect(rect).size().toSize();
+  if (deviceSize.isEmpty()) return;
+
+  // until it is rendered at this size, an older rendering is stretched;
+  // never rendered yet, it shows up once the background renderer is done
+  const QImage image = catalog()->image(elementIndex(), deviceSize);
+  if (image.isNull()) return;
+
+  painter->save();
+  painter->setClipRect(boundingRect());
+  if (image.size() != deviceSize)
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+  painter->drawImage(rect, image, image.rect());
+  if (isSelected())
+  {
+    painter->setPen(QPen(QApplication::palette().color(QPalette::Highlight), 0, Qt::DashLine));
+    painter->setBrush(Qt::NoBrush);
+    // inset by a device pixel so the clip does not hide the right and bottom edges
+    const QTransform &transform = painter->worldTransform();
+    painter->drawRect(boundingRect().adjusted(0, 0, -1 / transform.m11(), -1 / transform.m22()));
+  }
+  painter->restore();
+}
+
 QVariant ToDraw::itemChange(GraphicsItemChange change, const QVariant& value)
 {
-  if (change == QGraphicsItem::ItemPositionChange) {
+  // outside of a scene there is no geometry to keep up to date
+  if (change == QGraphicsItem::ItemPositionChange && scene()) {
     if (boundingRect() != clippedRectAt(value.toPointF()))
       prepareGeometryChange();
   }
-  return QGraphicsSvgItem::itemChange(change, value);
+  return QGraphicsItem::itemChange(change, value);
 }
 
 bool ToDraw::contains(const QPointF &point) const
 {
-	bool result = QGraphicsSvgItem::contains(point);
+	bool result = boundingRect().contains(point);
 	if (result)
 	{
-		QRectF bounds = transform().mapRect(unclippedRect());
-		const QImage &img = toImage(elementId(), qRound(bounds.width()), qRound(bounds.height()), renderer());
-		QPointF transformedPoint = transform().map(point);
-		result = qAlpha(img.pixel(transformedPoint.toPoint())) != 0;
+		const QSizeF size = unclippedRect().size();
+		result = catalog()->opaqueAt(elementIndex(), point.x() / size.width(), point.y() / size.height());
 	}
 	return result;
 }
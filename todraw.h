@@ -13,15 +13,27 @@
 #ifndef _TODRAW_H_
 #define _TODRAW_H_
 
-#include <QGraphicsSvgItem>
+#include <QGraphicsItem>
 
-class ToDraw : public QGraphicsSvgItem
+class ElementCatalog;
+
+// A plain QGraphicsItem, no QObject, no own transform nor element name.
+// Everything but the position and the stacking order lives in the
+// element catalog of the playground the 32 bit element handle points to.
+class ToDraw : public QGraphicsItem
 {
   public:
-    ToDraw();
-    
+    explicit ToDraw(quint32 element);
+
     void save(QDataStream &stream) const;
-    bool load(QDataStream &stream);
+    void save(QDataStream &stream, qreal stackingOrder) const;
+
+    quint32 element() const;
+    void setElement(quint32 element);
+    void elementChanged();
+    ElementCatalog *catalog() const;
+    int elementIndex() const;
+    QString elementId() const;
 
     bool contains(const QPointF &point) const;
 
@@ -31,6 +43,8 @@ class ToDraw : public QGraphicsSvgItem
     QRectF boundingRect() const;
     QRectF unclippedRect() const;
 
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0);
+
     void setBeingDragged(bool dragged);
 
   protected:
@@ -39,6 +53,7 @@ class ToDraw : public QGraphicsSvgItem
   private:
     QRectF clippedRectAt(const QPointF &somePos) const;
 
+    quint32 m_element;
     bool m_beingDragged;
 };
 
@@ -16,7 +16,7 @@
 #include <kfiledialog.h>
 #include <klocale.h>
 #include <KLocalizedString>
-#include <kio/netaccess.h>
+#include <kjob.h>
 #include <kstandardaction.h>
 #include <kstandardshortcut.h>
 #include <kstandardgameaction.h>
@@ -25,22 +25,37 @@
 #include <ktogglefullscreenaction.h>
 #include <kimageio.h>
 #include <kmimetype.h>
+#include <kconfig.h>
 #include <kconfiggroup.h>
 #include <kcombobox.h>
 
 #include <QApplication>
+#include <QBuffer>
 #include <QClipboard>
 #include <QFileInfo>
+#include <QIcon>
 #include <QPrintDialog>
 #include <QPrinter>
-#include <QTemporaryFile>
+#include <QSet>
+#include <QTabWidget>
+#include <QTimer>
+#include <QtConcurrentRun>
 #include <QWidgetAction>
 
+#include "boardprefetcher.h"
+#include "filetransfer.h"
+#include "inputrecorder.h"
+#include "memoryaccountant.h"
+#include "memorydialog.h"
 #include "playground.h"
+#include "sessionjournal.h"
 #include "soundfactory.h"
+#include "themewatcher.h"
 #include "playgrounddelegate.h"
+#include "startupprofiler.h"
 
 static const char *DEFAULT_THEME = "default_theme.theme";
+static const int WRITE_OPTIONS_DELAY = 3000; // ms
 
 // Constructor
 TopLevel::TopLevel()
@@ -48,12 +63,24 @@ TopLevel::TopLevel()
 {
   QString board, language;
 
-  playGround = new PlayGround(this);
-  playGround->setObjectName( QStringLiteral( "playGround" ) );
+  actionsView = 0;
+  undoAction = redoAction = closeViewAction = 0;
+
+  views = new QTabWidget(this);
+  views->setDocumentMode(true);
+  views->setTabsClosable(true);
+  views->setTabBarAutoHide(true);
+  connect(views, &QTabWidget::currentChanged, this, &TopLevel::currentViewChanged);
+  connect(views, &QTabWidget::tabCloseRequested, this, &TopLevel::closeView);
+  addView(0);
 
   soundFactory = new SoundFactory(this);
+  memoryAccountant = new MemoryAccountant(this);
+  prefetcher = new BoardPrefetcher(this);
+  themeWatcher = 0;
+  closeWhenSaved = false;
 
-  setCentralWidget(playGround);
+  setCentralWidget(views);
 
   playgroundsGroup = new QActionGroup(this);
   playgroundsGroup->setExclusive(true);
@@ -61,19 +88,48 @@ TopLevel::TopLevel()
   languagesGroup = new QActionGroup(this);
   languagesGroup->setExclusive(true);
 
-  setupKAction();
-
-  playGround->registerPlayGrounds();
-  soundFactory->registerLanguages();
+  optionsDirty = false;
+  writeOptionsTimer = new QTimer(this);
+  writeOptionsTimer->setSingleShot(true);
+  writeOptionsTimer->setInterval(WRITE_OPTIONS_DELAY);
+  connect(writeOptionsTimer, &QTimer::timeout, this, &TopLevel::flushOptions);
+  connect(qApp, &QCoreApplication::aboutToQuit, this, &TopLevel::syncOptions);
 
-  readOptions(board, language);
-  changeGameboard(board);
-  changeLanguage(language);
+  {
+    StartupPhase phase(QStringLiteral("setupKAction"));
+    setupKAction();
+  }
+  {
+    StartupPhase phase(QStringLiteral("registerPlayGrounds"));
+    currentPlayGround()->registerPlayGrounds();
+  }
+  {
+    StartupPhase phase(QStringLiteral("registerLanguages"));
+    soundFactory->registerLanguages();
+  }
+  {
+    StartupPhase phase(QStringLiteral("readOptions"));
+    readOptions(board, language);
+  }
+  {
+    StartupPhase phase(QStringLiteral("changeGameboard"));
+    changeGameboard(board);
+  }
+  {
+    StartupPhase phase(QStringLiteral("changeLanguage"));
+    changeLanguage(language);
+  }
+  {
+    StartupPhase phase(QStringLiteral("recoverSession"));
+    currentPlayGround()->recoverSession();
+    recoverViews();
+  }
 }
 
 // Destructor
 TopLevel::~TopLevel()
 {
+  syncOptions();
   delete soundFactory;
 }
 
@@ -120,7 +176,10 @@ void TopLevel::registerLanguage(const QString &code, const QString &soundFile, b
 void TopLevel::changeGameboardFromCombo(int index)
 {
   QString newBoard = playgroundCombo->itemData(index,BOARD_THEME).toString();
+  if (InputRecorder::isRecording()) InputRecorder::recordGameboard(newBoard);
+  const QString oldBoard = currentPlayGround()->currentGameboard();
   changeGameboard(newBoard);
+  prefetcher->recordSwitch(oldBoard, currentPlayGround()->currentGameboard());
 }
 
 void TopLevel::changeGameboard()
@@ -130,13 +189,24 @@ void TopLevel::changeGameboard()
   if (action->isChecked())
   {
     QString newGameBoard = action->data().toString();
+    // switching views checks the action of the view's playground
+    if (newGameBoard == currentPlayGround()->currentGameboard()) return;
+    if (InputRecorder::isRecording()) InputRecorder::recordGameboard(newGameBoard);
+    const QString oldGameBoard = currentPlayGround()->currentGameboard();
     changeGameboard(newGameBoard);
+    prefetcher->recordSwitch(oldGameBoard, currentPlayGround()->currentGameboard());
   }
 }
 
-void TopLevel::changeGameboard(const QString &newGameBoard)
+// Switch a view, the current one by default, to another gameboard. The
+// menu and the combo box follow the current view only. Only the switches
+// the user makes, through the slots above, teach the prefetcher.
+void TopLevel::changeGameboard(const QString &newGameBoard, PlayGround *playGround)
 {
-  if (newGameBoard == playGround->currentGameboard()) return;
+  if (!playGround) playGround = currentPlayGround();
+  const bool current = playGround == currentPlayGround();
+  const QString oldGameBoard = playGround->currentGameboard();
+  if (newGameBoard == oldGameBoard) return;
 
   QString fileToLoad;
   QFileInfo fi(newGameBoard);
@@ -149,12 +219,22 @@ void TopLevel::changeGameboard(const QString &newGameBoard)
     fileToLoad = newGameBoard;
   }
 
-  int index = playgroundCombo->findData(fileToLoad, BOARD_THEME);
-  playgroundCombo->setCurrentIndex(index);
+  // only the user changing the combo is a switch to record
+  if (current)
+  {
+    const bool blocked = playgroundCombo->blockSignals(true);
+    playgroundCombo->setCurrentIndex(playgroundCombo->findData(fileToLoad, BOARD_THEME));
+    playgroundCombo->blockSignals(blocked);
+  }
   QAction *action = actionCollection()->action(fileToLoad);
   if (action && playGround->loadPlayGround(fileToLoad))
   {
-    action->setChecked(true);
+    views->setTabText(views->indexOf(playGround), action->iconText());
+    if (current)
+    {
+      action->setChecked(true);
+      prefetcher->setCurrentGameboard(fileToLoad);
+    }
 
     // Change gameboard in the remembered options
     writeOptions();
@@ -164,7 +244,7 @@ void TopLevel::changeGameboard(const QString &newGameBoard)
     // Something bad just happened, try the default playground
     if (newGameBoard != QLatin1String(DEFAULT_THEME))
     {
-      changeGameboard(QLatin1String(DEFAULT_THEME));
+      changeGameboard(QLatin1String(DEFAULT_THEME), playGround);
     }
     else
     {
@@ -177,6 +257,7 @@ void TopLevel::changeLanguage()
 {
   QAction *action = qobject_cast<QAction*>(sender());
   QString soundFile = action->data().toString();
+  if (InputRecorder::isRecording()) InputRecorder::recordLanguage(soundFile);
   changeLanguage(soundFile);
 }
 
@@ -212,6 +293,159 @@ void TopLevel::changeLanguage(const QString &soundFile)
   }
 }
 
+PlayGround *TopLevel::currentPlayGround() const
+{
+  return viewAt(views->currentIndex());
+}
+
+// The playgrounds that can be switched to
+QStringList TopLevel::gameboards() const
+{
+  QStringList boards;
+  foreach(QAction *action, playgroundsGroup->actions())
+    boards << action->data().toString();
+  return boards;
+}
+
+// The languages that can be switched to, leaving out those without sounds
+QStringList TopLevel::soundFiles() const
+{
+  QStringList files;
+  foreach(QAction *action, languagesGroup->actions())
+  {
+    const QString file = action->data().toString();
+    if (action->isEnabled() && !file.isEmpty()) files << file;
+  }
+  return files;
+}
+
+QList<PlayGround *> TopLevel::playGrounds() const
+{
+  QList<PlayGround *> result;
+  for (int i = 0; i < views->count(); i++)
+    result << viewAt(i);
+  return result;
+}
+
+// Reload the playgrounds when their files change
+void TopLevel::watchThemes()
+{
+  if (!themeWatcher) themeWatcher = new ThemeWatcher(this);
+}
+
+PlayGround *TopLevel::viewAt(int index) const
+{
+  return static_cast<PlayGround *>(views->widget(index));
+}
+
+// Add a view, the playground is loaded by the caller
+PlayGround *TopLevel::addView(int view)
+{
+  PlayGround *playGround = new PlayGround(this, view);
+  if (view == 0)
+    playGround->setObjectName( QStringLiteral( "playGround" ) );
+  else
+    playGround->setObjectName( QStringLiteral( "playGround%1" ).arg(view) );
+  if (actionsView)
+    playGround->lockAspectRatio(actionsView->isAspectRatioLocked());
+
+  views->addTab(playGround, QString());
+  if (closeViewAction)
+    closeViewAction->setEnabled(views->count() > 1);
+  return playGround;
+}
+
+// The lowest number no open view uses, it names the journal of the view
+int TopLevel::freeViewNumber() const
+{
+  QSet<int> used;
+  for (int i = 0; i < views->count(); i++)
+    used << viewAt(i)->view();
+
+  int view = 0;
+  while (used.contains(view)) view++;
+  return view;
+}
+
+// Open another view of the current playground. The views share what was
+// parsed and rendered of each playground, only the stickers are their own.
+void TopLevel::newView()
+{
+  const QString board = currentPlayGround()->currentGameboard();
+  PlayGround *playGround = addView(freeViewNumber());
+  views->setCurrentWidget(playGround);
+  changeGameboard(board);
+}
+
+void TopLevel::closeView(int index)
+{
+  if (views->count() < 2) return;
+
+  PlayGround *playGround = viewAt(index);
+  if (playGround == actionsView)
+  {
+    playGround->disconnectAction(undoAction);
+    playGround->disconnectAction(redoAction);
+    actionsView = 0;
+  }
+  views->removeTab(index);
+  delete playGround;
+  closeViewAction->setEnabled(views->count() > 1);
+}
+
+void TopLevel::closeCurrentView()
+{
+  closeView(views->currentIndex());
+}
+
+// Undo, redo and the playground selection follow the current view
+void TopLevel::currentViewChanged()
+{
+  PlayGround *playGround = currentPlayGround();
+  if (!playGround || !undoAction || playGround == actionsView) return;
+
+  if (actionsView)
+  {
+    actionsView->disconnectAction(undoAction);
+    actionsView->disconnectAction(redoAction);
+  }
+  playGround->connectUndoAction(undoAction);
+  playGround->connectRedoAction(redoAction);
+  actionsView = playGround;
+
+  showGameboard(playGround->currentGameboard());
+}
+
+// Check the playground of the current view, without loading anything
+void TopLevel::showGameboard(const QString &board)
+{
+  if (board.isEmpty()) return;
+
+  QAction *action = actionCollection()->action(board);
+  if (action) action->setChecked(true);
+  prefetcher->setCurrentGameboard(board);
+
+  const bool blocked = playgroundCombo->blockSignals(true);
+  playgroundCombo->setCurrentIndex(playgroundCombo->findData(board, BOARD_THEME));
+  playgroundCombo->blockSignals(blocked);
+
+  // the playground of the current view is the one remembered
+  writeOptions();
+}
+
+// Give back the other views a crashed session had open
+void TopLevel::recoverViews()
+{
+  foreach(int view, SessionJournal::recoverableViews())
+  {
+    PlayGround *playGround = addView(view);
+    views->setCurrentWidget(playGround);
+    if (!playGround->recoverSession())
+      closeView(views->indexOf(playGround));
+  }
+  views->setCurrentIndex(0);
+}
+
 // Play a sound
 void TopLevel::playSound(const QString &ref) const
 {
@@ -228,6 +462,7 @@ void TopLevel::readOptions(QString &board, QString &language)
   board = config.readEntry("Gameboard", DEFAULT_THEME);
   language = config.readEntry("Language", "" );
   bool keepAspectRatio = config.readEntry("KeepAspectRatio", false);
+  actionCollection()->action(QStringLiteral( "save_undo_history" ))->setChecked(config.readEntry("SaveUndoHistory", false));
 
   if (soundEnabled)
   {
@@ -245,17 +480,78 @@ void TopLevel::readOptions(QString &board, QString &language)
   lockAspectRatio(keepAspectRatio);
 }
 
-// Write options to preferences file
+// Remember the options need to be written to the preferences file.
+// Changes are batched and only hit the disk once the user has stopped
+// changing things for a while, and again when quitting.
 void TopLevel::writeOptions()
 {
-  KConfigGroup config(KSharedConfig::openConfig(), "General");
-  config.writeEntry("Sound", actionCollection()->action(QStringLiteral( "speech_no_sound" ))->isChecked() ? "off": "on");
+  optionsDirty = true;
+  writeOptionsTimer->start();
+}
+
+// Runs in a thread of the pool, through a KConfig of its own: the shared
+// one belongs to the GUI thread
+static void writeOptionsCopy(const QString &configName, const QMap<QString, QString> &options, const BoardPrefetcher::Switches &switches)
+{
+  KConfig config(configName, KConfig::NoGlobals);
+  KConfigGroup general(&config, "General");
+  QMap<QString, QString>::const_iterator it;
+  for (it = options.constBegin(); it != options.constEnd(); ++it)
+    general.writeEntry(it.key(), it.value());
+  BoardPrefetcher::writeSwitches(&config, switches);
+  config.sync();
+}
+
+// Write a copy of the options and of the playground switch counts to the
+// preferences file, without the GUI waiting on the disk
+void TopLevel::flushOptions()
+{
+  if (!optionsDirty) return;
+
+  // one write at a time, the next one gets the latest values anyway
+  if (optionsWrite.isRunning())
+  {
+    writeOptionsTimer->start();
+    return;
+  }
+
+  writeOptionEntries();
+  optionsWrite = QtConcurrent::run(writeOptionsCopy, KSharedConfig::openConfig()->name(), optionEntries(), prefetcher->switches());
+}
+
+// Write the options when quitting, along with what else was put in the
+// configuration meanwhile
+void TopLevel::syncOptions()
+{
+  writeOptionsTimer->stop();
+  optionsWrite.waitForFinished();
+  if (optionsDirty)
+    writeOptionEntries();
+  KSharedConfig::openConfig()->sync();
+}
 
-  config.writeEntry("Gameboard", playGround->currentGameboard());
+QMap<QString, QString> TopLevel::optionEntries() const
+{
+  QMap<QString, QString> options;
+  options.insert(QStringLiteral( "Sound" ), actionCollection()->action(QStringLiteral( "speech_no_sound" ))->isChecked() ? QStringLiteral( "off" ) : QStringLiteral( "on" ));
+  options.insert(QStringLiteral( "Gameboard" ), currentPlayGround()->currentGameboard());
+  options.insert(QStringLiteral( "Language" ), soundFactory->currentSoundFile());
+  options.insert(QStringLiteral( "KeepAspectRatio" ), currentPlayGround()->isAspectRatioLocked() ? QStringLiteral( "true" ) : QStringLiteral( "false" ));
+  options.insert(QStringLiteral( "SaveUndoHistory" ), actionCollection()->action(QStringLiteral( "save_undo_history" ))->isChecked() ? QStringLiteral( "true" ) : QStringLiteral( "false" ));
+  return options;
+}
 
-  config.writeEntry("Language", soundFactory->currentSoundFile());
+// Put the options in the shared configuration, which is only written when
+// quitting
+void TopLevel::writeOptionEntries()
+{
+  optionsDirty = false;
 
-  config.writeEntry("KeepAspectRatio", playGround->isAspectRatioLocked());
+  KConfigGroup config(KSharedConfig::openConfig(), "General");
+  const QMap<QString, QString> options = optionEntries();
+  QMap<QString, QString>::const_iterator it;
+  for (it = options.constBegin(); it != options.constEnd(); ++it)
+    config.writeEntry(it.key(), it.value());
 }
 
 // KAction initialization (aka menubar + toolbar init)
@@ -268,7 +564,8 @@ void TopLevel::setupKAction()
   KStandardGameAction::load(this, SLOT(fileOpen()), actionCollection());
   KStandardGameAction::save(this, SLOT(fileSave()), actionCollection());
   KStandardGameAction::print(this, SLOT(filePrint()), actionCollection());
-  KStandardGameAction::quit(qApp, SLOT(quit()), actionCollection());
+  // through queryClose(), files may still be being saved
+  KStandardGameAction::quit(this, SLOT(close()), actionCollection());
 
   action = actionCollection()->addAction( QStringLiteral( "game_save_picture" ));
   action->setText(i18n("Save &as Picture..."));
@@ -278,13 +575,30 @@ void TopLevel::setupKAction()
   action = KStandardAction::copy(this, SLOT(editCopy()), actionCollection());
   actionCollection()->addAction(action->objectName(), action);
 
-  action = KStandardAction::undo(0, 0, actionCollection());
-  playGround->connectUndoAction(action);
-  action = KStandardAction::redo(0, 0, actionCollection());
-  playGround->connectRedoAction(action);
+  undoAction = KStandardAction::undo(0, 0, actionCollection());
+  redoAction = KStandardAction::redo(0, 0, actionCollection());
+  currentViewChanged();
+
+  //View
+  action = actionCollection()->addAction( QStringLiteral( "view_new" ));
+  action->setText(i18n("New &View"));
+  action->setIcon(QIcon::fromTheme( QStringLiteral( "tab-new" )));
+  actionCollection()->setDefaultShortcut(action, Qt::CTRL + Qt::Key_T);
+  connect(action, &QAction::triggered, this, &TopLevel::newView);
+
+  closeViewAction = KStandardAction::close(this, SLOT(closeCurrentView()), actionCollection());
+  closeViewAction->setEnabled(false);
+
+  action = actionCollection()->addAction( QStringLiteral( "memory_usage" ));
+  action->setText(i18n("&Memory Usage..."));
+  connect(action, &QAction::triggered, this, &TopLevel::showMemoryUsage);
+
+  KToggleAction *t = new KToggleAction(i18n("Save &Undo History"), this);
+  actionCollection()->addAction( QStringLiteral( "save_undo_history" ), t);
+  connect(t, &QAction::triggered, this, &TopLevel::writeOptions);
 
   //Speech
-  KToggleAction *t = new KToggleAction(i18n("&No Sound"), this);
+  t = new KToggleAction(i18n("&No Sound"), this);
   actionCollection()->addAction( QStringLiteral( "speech_no_sound" ), t);
   connect(t, &QAction::triggered, this, &TopLevel::soundOff);
   languagesGroup->addAction(t);
@@ -310,6 +624,7 @@ void TopLevel::setupKAction()
   widgetAction->setDefaultWidget(playgroundCombo);
   actionCollection()->addAction( QStringLiteral( "playgroundSelection" ),widgetAction);
 
+  StartupPhase phase(QStringLiteral("setupGUI"));
   setupGUI(ToolBar | Keys | Save | Create);
 }
 
@@ -325,7 +640,8 @@ void TopLevel::saveNewToolbarConfig()
 // Reset gameboard
 void TopLevel::fileNew()
 {
-  playGround->reset();
+  currentPlayGround()->reset();
+  if (InputRecorder::isRecording()) InputRecorder::recordScene(currentPlayGround());
 }
 
 // Load gameboard
@@ -337,16 +653,66 @@ void TopLevel::fileOpen()
   open(url);
 }
 
-void TopLevel::open(const QUrl &url)
+// The function is called once the file is loaded, or could not be;
+// input recordings and replays start from its board that way
+void TopLevel::open(const QUrl &url, const std::function<void()> &whenDone)
+{
+  KJob *job = startOpen(url, false);
+  if (job)
+    pendingOpens[job].whenDone = whenDone;
+  else if (whenDone)
+    whenDone();
+}
+
+// Open a file another launch handed over, leaving the views already open
+// alone
+void TopLevel::openInNewView(const QUrl &url)
+{
+  newView();
+  startOpen(url, true);
+}
+
+// Download the file in the background, the view it is for is loaded once
+// it is all there. KIO shows the progress and lets the user cancel.
+KJob *TopLevel::startOpen(const QUrl &url, bool ownView)
 {
   if (url.isEmpty())
+  {
+    if (ownView) closeCurrentView();
+    return 0;
+  }
+
+  KJob *job = FileTransfer::get(url, this);
+  connect(job, &KJob::result, this, &TopLevel::openFinished);
+
+  PendingOpen &pending = pendingOpens[job];
+  pending.view = currentPlayGround();
+  pending.ownView = ownView;
+  return job;
+}
+
+void TopLevel::openFinished(KJob *job)
+{
+  const PendingOpen pending = pendingOpens.take(job);
+  PlayGround *playGround = pending.view;
+  if (!playGround)			// the view was closed meanwhile
+  {
+    if (pending.whenDone) pending.whenDone();
     return;
+  }
 
-  QString name;
+  PlayGround::LoadError error = PlayGround::OtherError;
+  if (!job->error())
+  {
+    QByteArray data = FileTransfer::data(job);
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
 
-  KIO::NetAccess::download(url, name, this);
+    error = playGround->loadFrom(&buffer);
+    if (InputRecorder::isRecording()) InputRecorder::recordScene(playGround);
+  }
 
-  switch(playGround->loadFrom(name))
+  switch(error)
   {
     case PlayGround::NoError:
      // good
@@ -357,12 +723,54 @@ void TopLevel::open(const QUrl &url)
     break;
 
     case PlayGround::OtherError:
-      KMessageBox::error(this, i18n("Could not load file."));
+      if (job->error() != KJob::KilledJobError)
+        KMessageBox::error(this, i18n("Could not load file."));
     break;
   }
 
+  if (error != PlayGround::NoError && pending.ownView)
+    closeView(views->indexOf(playGround));
+  if (pending.whenDone)
+    pending.whenDone();
+}
+
+// Upload data in the background, KIO shows the progress and lets the
+// user cancel
+void TopLevel::startSave(const QByteArray &data, const QUrl &url)
+{
+  KJob *job = FileTransfer::put(data, url, this);
+  connect(job, &KJob::result, this, &TopLevel::saveFinished);
+  pendingSaves << job;
+}
+
+void TopLevel::saveFinished(KJob *job)
+{
+  pendingSaves.remove(job);
+  if (job->error() && job->error() != KJob::KilledJobError)
+  {
+    // the user gets to save again
+    closeWhenSaved = false;
+    KMessageBox::error(this, i18n("Could not save file."));
+  }
+
+  if (closeWhenSaved && pendingSaves.isEmpty())
+    close();
+}
+
+// Closing the window would drop the files still being saved
+bool TopLevel::queryClose()
+{
+  if (pendingSaves.isEmpty()) return true;
 
-  KIO::NetAccess::removeTempFile( name );
+  const int answer = KMessageBox::warningYesNoCancel(this,
+      i18n("A file is still being saved. If you quit now, it will not be written."),
+      QString(), KGuiItem(i18n("Quit When Saved")), KStandardGuiItem::quit());
+  if (answer == KMessageBox::Yes)
+  {
+    closeWhenSaved = true;
+    return false;
+  }
+  return answer == KMessageBox::No;
 }
 
 // Save gameboard
@@ -375,33 +783,17 @@ void TopLevel::fileSave()
   if (url.isEmpty())
     return;
 
-  QTemporaryFile tempFile; // for network saving
-  QString name;
-  if( !url.isLocalFile() )
-  {
-    if (tempFile.open()) name = tempFile.fileName();
-    else
-    {
-      KMessageBox::error(this, i18n("Could not save file."));
-      return;
-    }
-  }
-  else
-  {
-    name = url.path();
-  }
-
-  if( !playGround->saveAs( name ) )
+  QByteArray data;
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::WriteOnly);
+  const bool withHistory = actionCollection()->action(QStringLiteral( "save_undo_history" ))->isChecked();
+  if( !currentPlayGround()->saveTo( &buffer, withHistory ) )
   {
     KMessageBox::error(this, i18n("Could not save file."));
     return;
   }
 
-  if( !url.isLocalFile() )
-  {
-    if (!KIO::NetAccess::upload(name, url, this))
-      KMessageBox::error(this, i18n("Could not save file."));
-  }
+  startSave(data, url);
 }
 
 // Save gameboard as picture
@@ -424,18 +816,6 @@ void TopLevel::filePicture()
   if( url.isEmpty() )
     return;
 
-  QTemporaryFile tempFile; // for network saving
-  QString name;
-  if( !url.isLocalFile() )
-  {
-    tempFile.open();
-    name = tempFile.fileName();
-  }
-  else
-  {
-    name = url.path();
-  }
-
   KMimeType::Ptr mime = KMimeType::findByUrl(url, 0, true, true);
   if (!KImageIO::isSupported(mime->name(), KImageIO::Writing))
   {
@@ -446,21 +826,19 @@ void TopLevel::filePicture()
   QStringList types = KImageIO::typeForMime(mime->name());
   if (types.isEmpty()) return; // TODO error dialog?
 
-  QPixmap picture(playGround->getPicture());
+  QPixmap picture(currentPlayGround()->getPicture());
 
-  if (!picture.save(name, types.at(0).toLatin1()))
+  QByteArray data;
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::WriteOnly);
+  if (!picture.save(&buffer, types.at(0).toLatin1()))
   {
     KMessageBox::error
       (this, i18n("Could not save file."));
     return;
   }
 
-  if( !url.isLocalFile() )
-  {
-    if (! KIO::NetAccess::upload(name, url, this))
-      KMessageBox::error(this, i18n("Could not save file."));
-  }
-
+  startSave(data, url);
 }
 
 // Save gameboard as picture
@@ -470,12 +848,12 @@ void TopLevel::filePrint()
   bool ok;
 
   QPrintDialog *printDialog = new QPrintDialog(&printer, this);
-  printDialog->setWindowTitle(i18n("Print %1", actionCollection()->action(playGround->currentGameboard())->iconText()));
+  printDialog->setWindowTitle(i18n("Print %1", actionCollection()->action(currentPlayGround()->currentGameboard())->iconText()));
   ok = printDialog->exec();
   delete printDialog;
   if (!ok) return;
-  playGround->repaint();
-  if (!playGround->printPicture(printer))
+  currentPlayGround()->repaint();
+  if (!currentPlayGround()->printPicture(printer))
     KMessageBox::error(this,
                          i18n("Could not print picture."));
   else
@@ -487,7 +865,7 @@ void TopLevel::filePrint()
 void TopLevel::editCopy()
 {
   QClipboard *clipboard = QApplication::clipboard();
-  QPixmap picture(playGround->getPicture());
+  QPixmap picture(currentPlayGround()->getPicture());
 
   clipboard->setPixmap(picture);
 }
@@ -509,9 +887,16 @@ void TopLevel::toggleFullScreen()
   KToggleFullScreenAction::setFullScreen( this, actionCollection()->action(QStringLiteral( "fullscreen" ))->isChecked());
 }
 
+void TopLevel::showMemoryUsage()
+{
+  MemoryDialog *dialog = new MemoryDialog(memoryAccountant, this);
+  dialog->show();
+}
+
 void TopLevel::lockAspectRatio(bool lock)
 {
   actionCollection()->action(QStringLiteral( "lock_aspect_ratio" ))->setChecked(lock);
-  playGround->lockAspectRatio(lock);
+  for (int i = 0; i < views->count(); i++)
+    viewAt(i)->lockAspectRatio(lock);
   writeOptions();
 }
@@ -15,9 +15,23 @@
 #include <kurl.h>
 #include <kcombobox.h>
 
+#include <QFuture>
+#include <QHash>
+#include <QMap>
+#include <QPointer>
+#include <QSet>
+
+#include <functional>
+
+class KJob;
 class QActionGroup;
+class QTabWidget;
+class QTimer;
+class BoardPrefetcher;
+class MemoryAccountant;
 class PlayGround;
 class SoundFactory;
+class ThemeWatcher;
 
 class TopLevel : public KXmlGuiWindow
 {
@@ -28,7 +42,8 @@ public:
   TopLevel();
   ~TopLevel();
 
-  void open(const QUrl &url);
+  void open(const QUrl &url, const std::function<void()> &whenDone = std::function<void()>());
+  void openInNewView(const QUrl &url);
   void registerGameboard(const QString& menuText, const QString& boardFile, const QPixmap& pixmap);
   void registerLanguage(const QString &code, const QString &soundFile, bool enabled);
   void changeLanguage(const QString &langCode);
@@ -36,17 +51,35 @@ public:
 
   bool isSoundEnabled() const;
 
-  void changeGameboard(const QString &gameboard);
+  void changeGameboard(const QString &gameboard, PlayGround *playGround = 0);
+
+  PlayGround *currentPlayGround() const;
+  QStringList gameboards() const;
+  QStringList soundFiles() const;
+  QList<PlayGround *> playGrounds() const;
+  void watchThemes();
 
 protected:
   void readOptions(QString &board, QString &language);
   void writeOptions();
+  void writeOptionEntries();
+  QMap<QString, QString> optionEntries() const;
   void setupKAction();
+  PlayGround *addView(int view);
+  PlayGround *viewAt(int index) const;
+  int freeViewNumber() const;
+  void recoverViews();
+  void showGameboard(const QString &board);
+  KJob *startOpen(const QUrl &url, bool ownView);
+  void startSave(const QByteArray &data, const QUrl &url);
+  bool queryClose() Q_DECL_OVERRIDE;
 
 protected slots:
   void saveNewToolbarConfig();
 
 private slots:
+  void flushOptions();
+  void syncOptions();
 
   void fileNew();
   void fileOpen();
@@ -60,6 +93,13 @@ private slots:
   void changeLanguage();
   void toggleFullScreen();
   void lockAspectRatio(bool lock);
+  void newView();
+  void closeView(int index);
+  void closeCurrentView();
+  void currentViewChanged();
+  void showMemoryUsage();
+  void openFinished(KJob *job);
+  void saveFinished(KJob *job);
 
 private:
   int                           // Menu items identificators
@@ -75,9 +115,28 @@ private:
 
   QActionGroup *playgroundsGroup, *languagesGroup;
   KComboBox *playgroundCombo;
-
-  PlayGround *playGround;	// Play ground central widget
+  QTimer *writeOptionsTimer;	// Delays writing the options until things calm down
+  QFuture<void> optionsWrite;	// Writes a copy of them in the background
+  bool optionsDirty;		// Options changed since they were last written
+
+  QTabWidget *views;		// Play grounds, the central widget
+  PlayGround *actionsView;	// the view undo and redo act on
+  QAction *undoAction, *redoAction, *closeViewAction;
+
+  class PendingOpen
+  {
+    public:
+      QPointer<PlayGround> view;	// the view the file is loaded into
+      bool ownView;			// whether the view was opened for the file
+      std::function<void()> whenDone;	// called once it is loaded or failed
+  };
+  QHash<KJob *, PendingOpen> pendingOpens;
+  QSet<KJob *> pendingSaves;		// uploads still running
+  bool closeWhenSaved;			// the user asked to quit once they are done
   SoundFactory *soundFactory;	// Speech organ
+  MemoryAccountant *memoryAccountant;
+  BoardPrefetcher *prefetcher;		// gets the next playgrounds ready
+  ThemeWatcher *themeWatcher;		// only for theme authors
   QMap<QString, QString> sounds; // language code, file
 };
 
@@ -0,0 +1,99 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Input-to-paint latency tracing */
+
+#include "tracer.h"
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+
+namespace
+{
+  struct TraceEvent
+  {
+    const char *name;
+    qint64 start;	// nanoseconds since tracing was enabled
+    qint64 duration;
+    quintptr thread;
+  };
+
+  // must be a power of two
+  const int ringSize = 1 << 16;
+
+  TraceEvent ring[ringSize];
+  QAtomicInt nextEvent;
+  QElapsedTimer clock;
+  QString outputFileName;
+}
+
+bool Tracer::s_enabled = false;
+
+void Tracer::enable(const QString &outputFile)
+{
+  if (outputFile.isEmpty()) return;
+
+  outputFileName = outputFile;
+  clock.start();
+  s_enabled = true;
+}
+
+qint64 Tracer::now()
+{
+  return clock.nsecsElapsed();
+}
+
+void Tracer::record(const char *name, qint64 start, qint64 end)
+{
+  if (!s_enabled) return;
+
+  // Writers only contend on the index, once we have a slot it is ours.
+  // Old events get overwritten when the buffer wraps around.
+  const int slot = nextEvent.fetchAndAddRelaxed(1) & (ringSize - 1);
+  TraceEvent &event = ring[slot];
+  event.name = name;
+  event.start = start;
+  event.duration = end - start;
+  event.thread = reinterpret_cast<quintptr>(QThread::currentThreadId());
+}
+
+bool Tracer::dump()
+{
+  if (!s_enabled) return false;
+
+  QFile f(outputFileName);
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  const int written = nextEvent.load();
+  const int count = qMin(written, ringSize);
+  const int first = written - count;
+  const qint64 pid = QCoreApplication::applicationPid();
+
+  QTextStream out(&f);
+  out << "{\"traceEvents\":[";
+  for (int i = 0; i < count; i++)
+  {
+    const TraceEvent &event = ring[(first + i) & (ringSize - 1)];
+    if (i > 0) out << ',';
+    // Chrome wants microseconds, keep the sub microsecond part as decimals
+    out << "\n{\"name\":\"" << event.name << "\",\"cat\":\"ktuberling\",\"ph\":\"X\""
+        << ",\"ts\":" << QString::number(event.start / 1000.0, 'f', 3)
+        << ",\"dur\":" << QString::number(event.duration / 1000.0, 'f', 3)
+        << ",\"pid\":" << pid << ",\"tid\":" << event.thread << '}';
+  }
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  out.flush();
+
+  return f.error() == QFile::NoError;
+}
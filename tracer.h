@@ -0,0 +1,55 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Input-to-paint latency tracing */
+
+#ifndef _TRACER_H_
+#define _TRACER_H_
+
+#include <QString>
+
+// Collects timing events in a fixed size ring buffer and dumps them
+// as Chrome trace-event JSON (load it in chrome://tracing).
+// When tracing is not enabled every call is a single bool check.
+class Tracer
+{
+  public:
+    static void enable(const QString &outputFile);
+    static inline bool isEnabled() { return s_enabled; }
+
+    static qint64 now();
+    static void record(const char *name, qint64 start, qint64 end);
+    static bool dump();
+
+  private:
+    static bool s_enabled;
+};
+
+// Records the time spent between construction and destruction
+class TraceScope
+{
+  public:
+    explicit TraceScope(const char *name)
+     : m_name(name), m_start(Tracer::isEnabled() ? Tracer::now() : -1)
+    {
+    }
+
+    ~TraceScope()
+    {
+      if (m_start >= 0) Tracer::record(m_name, m_start, Tracer::now());
+    }
+
+  private:
+    Q_DISABLE_COPY(TraceScope)
+
+    const char *m_name;
+    qint64 m_start;
+};
+
+#endif
@@ -0,0 +1,102 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Thumbnails of saved potatoes for file managers */
+
+#include "tuberlingthumbnail.h"
+
+#include <QFile>
+#include <QPainter>
+#include <QStandardPaths>
+#include <QtAlgorithms>
+
+#include "elementcatalog.h"
+#include "savedgame.h"
+#include "thememanifest.h"
+
+extern "C"
+{
+  Q_DECL_EXPORT ThumbCreator *new_creator()
+  {
+    return new TuberlingCreator;
+  }
+}
+
+static bool zValueLessThan(const SavedGame::Sticker &a, const SavedGame::Sticker &b)
+{
+  return a.zValue < b.zValue;
+}
+
+// The file installed with the game, this runs outside of its data location
+static QString gameFile(const QString &name)
+{
+  return QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1String( "ktuberling/pics/" ) + name);
+}
+
+bool TuberlingCreator::create(const QString &path, int width, int height, QImage &image)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) return false;
+
+  // the undo history is of no use here
+  SavedGame saved;
+  if (saved.read(&file, false) != SavedGame::Read) return false;
+  QList<SavedGame::Sticker> &stickers = saved.stickers;
+  qStableSort(stickers.begin(), stickers.end(), zValueLessThan);
+
+  const QString gameboardFile = gameFile(saved.board);
+  const ThemeManifest *manifest = ThemeManifest::get(gameboardFile);
+  if (!manifest) return false;
+
+  ElementCatalog *catalog = ElementCatalog::forGameboard(gameboardFile);
+  if (!catalog->isLoaded() && !catalog->loadGameboard(gameboardFile, gameFile(manifest->gameboard)))
+    return false;
+
+  const QRectF background = catalog->backgroundRect();
+  QSize size = background.size().toSize();
+  size.scale(width, height, Qt::KeepAspectRatio);
+  if (size.isEmpty()) return false;
+
+  image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+  image.fill(QColor(manifest->bgColor));
+
+  QPainter painter(&image);
+  painter.setRenderHint(QPainter::SmoothPixmapTransform);
+  painter.scale(size.width() / background.width(), size.height() / background.height());
+  painter.translate(-background.topLeft());
+  painter.setClipRect(background);
+
+  const QRectF boardRect(QPointF(0, 0), catalog->defaultSize());
+  const QImage preview = catalog->preview();
+  if (preview.isNull())
+    catalog->renderer()->render(&painter, boardRect);
+  else
+    painter.drawImage(boardRect, preview);
+
+  // file managers ask for the same few sizes, the stickers are drawn from
+  // renderings the game or earlier thumbnails left in the sprite cache
+  foreach(const SavedGame::Sticker &sticker, stickers)
+  {
+    const int id = catalog->intern(sticker.element);
+    // only objects of the warehouse are drawn, as on the board
+    if (id < 0 || catalog->scale(id) <= 0) continue;
+    const QRectF rect(sticker.pos, catalog->scaledSize(id));
+    const QSize deviceSize = painter.worldTransform().mapRect(rect).size().toSize();
+    if (deviceSize.isEmpty()) continue;
+    painter.drawImage(rect, catalog->spriteImage(id, deviceSize));
+  }
+  painter.end();
+
+  return true;
+}
+
+ThumbCreator::Flags TuberlingCreator::flags() const
+{
+  return None;
+}
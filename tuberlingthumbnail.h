@@ -0,0 +1,28 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by The KTuberling Developers                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/* Thumbnails of saved potatoes for file managers */
+
+#ifndef _TUBERLINGTHUMBNAIL_H_
+#define _TUBERLINGTHUMBNAIL_H_
+
+#include <KIO/ThumbCreator>
+
+// Draws a .tuberling file with the element catalog of its playground,
+// without any widget. The board comes from the low resolution preview
+// the game saved, the elements from the sprite cache the game shares,
+// rendered from their fragments in the bundle when they are not there.
+class TuberlingCreator : public ThumbCreator
+{
+  public:
+    bool create(const QString &path, int width, int height, QImage &image) Q_DECL_OVERRIDE;
+    Flags flags() const Q_DECL_OVERRIDE;
+};
+
+#endif